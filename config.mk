@@ -3,3 +3,5 @@
 PREFIX?=/usr
 PLUGINDIR?=lib/wireshark/libwireshark0/plugins
 WIRESHARKDIR?=/usr/include/wireshark
+#interpreter for the value_string table checker run before each compile
+PYTHON?=python3
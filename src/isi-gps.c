@@ -24,6 +24,8 @@
 #include <glib.h>
 #include <epan/prefs.h>
 #include <epan/packet.h>
+#include <epan/emem.h>
+#include <epan/tap.h>
 
 #include "packet-isi.h"
 #include "isi-gps.h"
@@ -33,22 +35,13 @@
 #define SAT_PKG_LEN 12
 
 static const value_string isi_gps_id[] = {
-	//{0x0d, "GPS_UNKNOWN_0D"},
-	//{0x0e, "GPS_UNKNOWN_0E"},
 	{0x7d, "GPS_STATUS_IND"},
-	//{0x7e, "GPS_UNKNOWN_7E"},
-	//{0x7f, "GPS_UNKNOWN_7F"},
-	//{0x82, "GPS_UNKNOWN_82"},
-	//{0x83, "GPS_UNKNOWN_83"},
-	//{0x84, "GPS_UNKNOWN_84"},
-	//{0x85, "GPS_UNKNOWN_85"},
-	//{0x90, "GPS_UNKNOWN_90"},
-	//{0x91, "GPS_UNKNOWN_91"},
 	{0x90, "GPS_POWER_STATUS_REQ"},
 	{0x91, "GPS_POWER_STATUS_RSP"},
 	{0x92, "GPS_DATA_IND"},
-	{0x00, NULL }
+	{0x00, NULL}
 };
+static value_string_ext isi_gps_id_ext = VALUE_STRING_EXT_INIT(isi_gps_id);
 
 static const value_string isi_gps_sub_id[] = {
 	{0x02, "GPS_POSITION"},
@@ -67,9 +60,6 @@ static const value_string isi_gps_status[] = {
 	{0x00, NULL }
 };
 
-static dissector_handle_t isi_gps_handle;
-static void dissect_isi_gps(tvbuff_t *tvb, packet_info *pinfo, proto_item *tree);
-
 static guint32 hf_isi_gps_cmd = -1;
 static guint32 hf_isi_gps_sub_pkgs = -1;
 static guint32 hf_isi_gps_sub_type = -1;
@@ -104,19 +94,12 @@ static guint32 hf_isi_gps_sat_strength = -1;
 static guint32 hf_isi_gps_sat_elevation = -1;
 static guint32 hf_isi_gps_sat_azimuth = -1;
 
-void proto_reg_handoff_isi_gps(void) {
-	static gboolean initialized=FALSE;
-
-	if (!initialized) {
-		isi_gps_handle = create_dissector_handle(dissect_isi_gps, proto_isi);
-		dissector_add("isi.resource", 0x54, isi_gps_handle);
-	}
-}
+static int isi_gps_tap = -1;
 
 void proto_register_isi_gps(void) {
 	static hf_register_info hf[] = {
 		{ &hf_isi_gps_cmd,
-		  { "Command", "isi.gps.cmd", FT_UINT8, BASE_HEX, isi_gps_id, 0x0, "Command", HFILL }},
+		  { "Command", "isi.gps.cmd", FT_UINT8, BASE_HEX|BASE_EXT_STRING, &isi_gps_id_ext, 0x0, "Command", HFILL }},
 		{ &hf_isi_gps_sub_pkgs,
 		  { "Number of Subpackets", "isi.gps.pkgs", FT_UINT8, BASE_DEC, NULL, 0x0, "Number of Subpackets", HFILL }},
 		{ &hf_isi_gps_sub_type,
@@ -184,49 +167,297 @@ void proto_register_isi_gps(void) {
 	};
 
 	proto_register_field_array(proto_isi, hf, array_length(hf));
-	register_dissector("isi.gps", dissect_isi_gps, proto_isi);
+	isi_gps_tap = register_tap("isi.gps");
+}
+
+/* parsed GPS_DATA_IND, cached per frame */
+typedef struct _isi_gps_subpkg_t {
+	guint offset;
+	guint8 type;
+	guint8 len;
+	gboolean too_short;	/* fields do not fit into the block */
+	union {
+		struct {
+			double lat;
+			double lon;
+			float eph;
+			gint32 altitude;
+			float epv;
+		} pos;
+		struct {
+			guint16 year;
+			guint8 month;
+			guint8 day;
+			guint8 hour;
+			guint8 minute;
+			float second;
+		} time;
+		struct {
+			float course;
+			float epd;
+			float speed;
+			float eps;
+			float climb;
+			float epc;
+		} move;
+		struct {
+			guint8 count;
+			isi_gps_sat_t *sat;
+		} sats;
+		struct {
+			guint16 mcc;
+			guint16 mnc;
+			guint16 lac;	/* GSM only */
+			guint32 cid;
+		} cell;
+	} u;
+} isi_gps_subpkg_t;
+
+typedef struct _isi_gps_data_t {
+	guint8 count;
+	gboolean malformed;
+	guint malformed_offset;
+	isi_gps_subpkg_t *pkg;
+} isi_gps_data_t;
+
+/* number of bytes following the subpacket header, which are decoded */
+static guint isi_gps_subpkg_need(tvbuff_t *tvb, guint8 type, guint offset, guint avail) {
+	switch(type) {
+		case 0x02: return 24;
+		case 0x03: return 10;
+		case 0x04: return 14;
+		case 0x05: return avail ? 4 + tvb_get_guint8(tvb, offset) * SAT_PKG_LEN : 1;
+		case 0x07:
+		case 0x08: return 8;
+		default:   return 0;
+	}
+}
+
+static isi_gps_data_t *isi_gps_parse_data(tvbuff_t *tvb) {
+	isi_gps_data_t *data = se_new0(isi_gps_data_t);
+	isi_subblock_iter_t it;
+	const guint8 *p;
+	guint offset, need;
+	int sat;
+
+	if(tvb_length(tvb) < 0x0b) {
+		data->malformed = TRUE;
+		return data;
+	}
+
+	// subpackets start at 0x0b
+	isi_subblock_iter_init(&it, tvb, 0x0b, tvb_get_guint8(tvb, 0x07), 4, 1, 3);
+	data->pkg = se_alloc0(it.count * sizeof(isi_gps_subpkg_t));
+
+	while(isi_subblock_iter_next(&it)) {
+		isi_gps_subpkg_t *sp = &data->pkg[data->count++];
+
+		sp->offset = it.block_offset;
+		sp->type = it.type;
+		sp->len = it.len;
+
+		offset = sp->offset + 4;
+		need = isi_gps_subpkg_need(tvb, sp->type, offset, sp->len - 4);
+		if(need > (guint) sp->len - 4) {
+			sp->too_short = TRUE;
+			continue;
+		}
+
+		/* one bounds check per subpacket, the fields are read directly */
+		if(!need)
+			continue;
+		p = tvb_get_ptr(tvb, offset, need);
+
+		switch(sp->type) {
+			case 0x02: // Position
+				sp->u.pos.lat = pntohl(p+0);
+				sp->u.pos.lat = (sp->u.pos.lat*360)/4294967296;
+				if(sp->u.pos.lat > 180.0) sp->u.pos.lat -= 360.0;
+
+				sp->u.pos.lon = pntohl(p+4);
+				sp->u.pos.lon = (sp->u.pos.lon*360)/4294967296;
+				if(sp->u.pos.lon > 180.0) sp->u.pos.lon -= 360.0;
+
+				sp->u.pos.eph = pntohl(p+12) / 100.0;
+				sp->u.pos.altitude = (pntohs(p+18) - pntohs(p+22))/2;
+				sp->u.pos.epv = pntohs(p+20) / 2;
+				break;
+			case 0x03: // Date and Time
+				sp->u.time.year   = pntohs(p+0);
+				sp->u.time.month  = p[2];
+				sp->u.time.day    = p[3];
+				sp->u.time.hour   = p[5];
+				sp->u.time.minute = p[6];
+				sp->u.time.second = pntohs(p+8) / 1000.0;
+				break;
+			case 0x04: // Movement
+				sp->u.move.course = pntohs(p+0) / 100.0;
+				sp->u.move.epd    = pntohs(p+2) / 100.0;
+				sp->u.move.speed  = pntohs(p+6) * CMS_TO_KMH;
+				sp->u.move.eps    = pntohs(p+8) * CMS_TO_KMH;
+				sp->u.move.climb  = pntohs(p+10) * CMS_TO_KMH;
+				sp->u.move.epc    = pntohs(p+12) * CMS_TO_KMH;
+				break;
+			case 0x05: // Satellite Info
+				sp->u.sats.count = p[0];
+				sp->u.sats.sat = se_alloc(sp->u.sats.count * sizeof(isi_gps_sat_t));
+
+				for(sat = 0, p += 4; sat < sp->u.sats.count; sat++, p += SAT_PKG_LEN) {
+					sp->u.sats.sat[sat].prn       = p[1];
+					sp->u.sats.sat[sat].used      = p[2] != 0;
+					sp->u.sats.sat[sat].strength  = pntohs(p+3) / 100.0;
+					sp->u.sats.sat[sat].elevation = pntohs(p+6) / 100.0;
+					sp->u.sats.sat[sat].azimuth   = pntohs(p+8) / 100.0;
+				}
+				break;
+			case 0x07: // CellInfo GSM
+				sp->u.cell.mcc = pntohs(p+0);
+				sp->u.cell.mnc = pntohs(p+2);
+				sp->u.cell.lac = pntohs(p+4);
+				sp->u.cell.cid = pntohs(p+6);
+				break;
+			case 0x08: // CellInfo WCDMA
+				sp->u.cell.mcc = pntohs(p+0);
+				sp->u.cell.mnc = pntohs(p+2);
+				sp->u.cell.cid = pntohl(p+4);
+				break;
+			default:
+				break;
+		}
+	}
+
+	data->malformed = it.malformed;
+	data->malformed_offset = it.offset;
+
+	return data;
+}
+
+static void isi_gps_tap_queue(tvbuff_t *tvb, packet_info *pinfo, guint8 status, const isi_gps_data_t *data) {
+	isi_gps_tap_info_t *info;
+	int i;
+
+	if(!have_tap_listener(isi_gps_tap))
+		return;
+
+	info = ep_alloc0(sizeof(isi_gps_tap_info_t));
+	info->msg_id = tvb_get_guint8(tvb, 0);
+	info->status = status;
+
+	for(i=0; data && i<data->count; i++) {
+		const isi_gps_subpkg_t *sp = &data->pkg[i];
+
+		if(sp->too_short)
+			continue;
+
+		switch(sp->type) {
+			case 0x02: // Position
+				/* 0/0 does not count as a fix */
+				if(sp->u.pos.lat == 0.0 && sp->u.pos.lon == 0.0)
+					break;
+
+				info->has_position = TRUE;
+				info->lat = sp->u.pos.lat;
+				info->lon = sp->u.pos.lon;
+				info->eph = sp->u.pos.eph;
+				info->altitude = sp->u.pos.altitude;
+				info->epv = sp->u.pos.epv;
+				break;
+			case 0x03: // Date and Time
+				if(!sp->u.time.year)
+					break;
+
+				info->has_time = TRUE;
+				info->year = sp->u.time.year;
+				info->month = sp->u.time.month;
+				info->day = sp->u.time.day;
+				info->hour = sp->u.time.hour;
+				info->minute = sp->u.time.minute;
+				info->second = sp->u.time.second;
+				break;
+			case 0x04: // Movement
+				info->has_movement = TRUE;
+				info->course = sp->u.move.course;
+				info->speed = sp->u.move.speed;
+				info->climb = sp->u.move.climb;
+				break;
+			case 0x05: ; // Satellite Info
+				int sat;
+
+				info->has_satellites = TRUE;
+				info->satellites = sp->u.sats.count;
+				info->sat = sp->u.sats.sat;
+				for(sat = 0; sat < sp->u.sats.count; sat++)
+					if(sp->u.sats.sat[sat].used)
+						info->satellites_used++;
+				break;
+			case 0x07: // CellInfo GSM
+			case 0x08: // CellInfo WCDMA
+				info->has_cell = TRUE;
+				info->wcdma = sp->type == 0x08;
+				info->mcc = sp->u.cell.mcc;
+				info->mnc = sp->u.cell.mnc;
+				info->lac = sp->u.cell.lac;
+				info->cid = sp->u.cell.cid;
+				break;
+			default:
+				break;
+		}
+	}
+
+	tap_queue_packet(isi_gps_tap, pinfo, info);
 }
 
 static void dissect_isi_gps_data(tvbuff_t *tvb, packet_info *pinfo, proto_item *item, proto_tree *tree) {
-	guint8 len = tvb->length;
+	isi_gps_data_t *data;
 	int i;
 
-	guint8 pkgcount = tvb_get_guint8(tvb, 0x07);
-	proto_tree_add_item(tree, hf_isi_gps_sub_pkgs, tvb, 0x07, 1, FALSE);
+	col_set_str(pinfo->cinfo, COL_INFO, "GPS Data");
 
-	size_t offset = 0x0b; // subpackets start here
-	for(i=0; i<pkgcount; i++) {
-		guint8 sptype = tvb_get_guint8(tvb, offset+1);
-		guint8 splen = tvb_get_guint8(tvb, offset+3);
+	/* column and filter passes without a tap skip the subpacket walk */
+	if(!tree && !have_tap_listener(isi_gps_tap))
+		return;
 
-		proto_item *subitem = proto_tree_add_text(tree, tvb, offset, splen, "Subpacket (%s)", val_to_str(sptype, isi_gps_sub_id, "unknown: 0x%x"));
-		proto_tree *subtree = proto_item_add_subtree(subitem, ett_isi_msg);
+	data = isi_get_frame_data(pinfo, tvb);
+	if(!data) {
+		data = isi_gps_parse_data(tvb);
+		isi_add_frame_data(pinfo, tvb, data);
+	}
 
-		proto_tree_add_item(subtree, hf_isi_gps_sub_type, tvb, offset+1, 1, FALSE);
-		proto_tree_add_item(subtree, hf_isi_gps_sub_len, tvb,  offset+3, 1, FALSE);
+	isi_gps_tap_queue(tvb, pinfo, 0, data);
 
-		offset += 4;
-		switch(sptype) {
-			case 0x02: ; // Position
-				double lat = tvb_get_ntohl(tvb, offset+0);
-				lat = (lat*360)/4294967296;
-				if(lat > 180.0) lat -= 360.0;
-				proto_tree_add_double(subtree, hf_isi_gps_latitude, tvb, offset+0, 4, lat);
+	if(!tree)
+		return;
+
+	if(tvb_length(tvb) < 0x0b) {
+		isi_expert_add(pinfo, item, PI_MALFORMED, PI_ERROR, 0x54, 0x92, 0, "GPS data too short");
+		return;
+	}
 
-				double lon = tvb_get_ntohl(tvb, offset+4);
-				lon = (lon*360)/4294967296;
-				if(lon > 180.0) lon -= 360.0;
-				proto_tree_add_double(subtree, hf_isi_gps_longitude, tvb, offset+4, 4, lon);
+	proto_tree_add_item(tree, hf_isi_gps_sub_pkgs, tvb, 0x07, 1, FALSE);
 
-				float eph = tvb_get_ntohl(tvb, offset+12) / 100.0;
-				proto_tree_add_float(subtree, hf_isi_gps_eph, tvb, offset+12, 4, eph);
+	for(i=0; i<data->count; i++) {
+		isi_gps_subpkg_t *sp = &data->pkg[i];
+		guint offset = sp->offset;
 
-				gint32 altitude = (tvb_get_ntohs(tvb, offset+18) - tvb_get_ntohs(tvb, offset+22))/2;
-				proto_tree_add_int(subtree, hf_isi_gps_altitude, tvb, offset+18, 6, altitude);
+		proto_item *subitem = proto_tree_add_text(tree, tvb, offset, sp->len, "Subpacket (%s)", val_to_str(sp->type, isi_gps_sub_id, "unknown: 0x%x"));
+		proto_tree *subtree = proto_item_add_subtree(subitem, ett_isi_msg);
+
+		proto_tree_add_item(subtree, hf_isi_gps_sub_type, tvb, offset+1, 1, FALSE);
+		proto_tree_add_item(subtree, hf_isi_gps_sub_len, tvb,  offset+3, 1, FALSE);
 
-				float epv = tvb_get_ntohs(tvb, offset+20) / 2;
-				proto_tree_add_float(subtree, hf_isi_gps_epv, tvb, offset+20, 2, epv);
+		if(sp->too_short) {
+			isi_expert_add(pinfo, subitem, PI_MALFORMED, PI_ERROR, 0x54, 0x92, sp->type, "Subpacket too short (%d bytes)", sp->len);
+			continue;
+		}
 
+		offset += 4;
+		switch(sp->type) {
+			case 0x02: // Position
+				proto_tree_add_double(subtree, hf_isi_gps_latitude, tvb, offset+0, 4, sp->u.pos.lat);
+				proto_tree_add_double(subtree, hf_isi_gps_longitude, tvb, offset+4, 4, sp->u.pos.lon);
+				proto_tree_add_float(subtree, hf_isi_gps_eph, tvb, offset+12, 4, sp->u.pos.eph);
+				proto_tree_add_int(subtree, hf_isi_gps_altitude, tvb, offset+18, 6, sp->u.pos.altitude);
+				proto_tree_add_float(subtree, hf_isi_gps_epv, tvb, offset+20, 2, sp->u.pos.epv);
 				break;
 			case 0x03: // Date and Time
 				proto_tree_add_item(subtree, hf_isi_gps_year,    tvb, offset+0, 2, FALSE);
@@ -234,48 +465,31 @@ static void dissect_isi_gps_data(tvbuff_t *tvb, packet_info *pinfo, proto_item *
 				proto_tree_add_item(subtree, hf_isi_gps_day,     tvb, offset+3, 1, FALSE);
 				proto_tree_add_item(subtree, hf_isi_gps_hour,    tvb, offset+5, 1, FALSE);
 				proto_tree_add_item(subtree, hf_isi_gps_minute,  tvb, offset+6, 1, FALSE);
-
-				float second = tvb_get_ntohs(tvb, offset+8) / 1000.0;
-				proto_tree_add_float(subtree, hf_isi_gps_second, tvb, offset+8, 2, second);
+				proto_tree_add_float(subtree, hf_isi_gps_second, tvb, offset+8, 2, sp->u.time.second);
 				break;
-			case 0x04: ; // Movement
-				float course = tvb_get_ntohs(tvb, offset+0) / 100.0;
-				proto_tree_add_float(subtree, hf_isi_gps_course, tvb, offset+0, 2, course);
-
-				float epd = tvb_get_ntohs(tvb, offset+2) / 100.0;
-				proto_tree_add_float(subtree, hf_isi_gps_epd, tvb, offset+2, 2, epd);
-
-				float speed = tvb_get_ntohs(tvb, offset+6) * CMS_TO_KMH;
-				proto_tree_add_float(subtree, hf_isi_gps_speed, tvb, offset+6, 2, speed);
-
-				float eps = tvb_get_ntohs(tvb, offset+8) * CMS_TO_KMH;
-				proto_tree_add_float(subtree, hf_isi_gps_eps, tvb, offset+8, 2, eps);
-
-				float climb = tvb_get_ntohs(tvb, offset+10) * CMS_TO_KMH;
-				proto_tree_add_float(subtree, hf_isi_gps_climb, tvb, offset+10, 2, climb);
-
-				float epc = tvb_get_ntohs(tvb, offset+12) * CMS_TO_KMH;
-				proto_tree_add_float(subtree, hf_isi_gps_epc, tvb, offset+12, 2, epc);
+			case 0x04: // Movement
+				proto_tree_add_float(subtree, hf_isi_gps_course, tvb, offset+0, 2, sp->u.move.course);
+				proto_tree_add_float(subtree, hf_isi_gps_epd, tvb, offset+2, 2, sp->u.move.epd);
+				proto_tree_add_float(subtree, hf_isi_gps_speed, tvb, offset+6, 2, sp->u.move.speed);
+				proto_tree_add_float(subtree, hf_isi_gps_eps, tvb, offset+8, 2, sp->u.move.eps);
+				proto_tree_add_float(subtree, hf_isi_gps_climb, tvb, offset+10, 2, sp->u.move.climb);
+				proto_tree_add_float(subtree, hf_isi_gps_epc, tvb, offset+12, 2, sp->u.move.epc);
 				break;
 			case 0x05: ; // Satellite Info
-				guint8 satellites = tvb_get_guint8(tvb, offset+0);
 				proto_tree_add_item(subtree, hf_isi_gps_satellites, tvb, offset+0, 1, FALSE);
-				
+
 				int sat;
-				for(sat = 0; sat < satellites ; sat++) {
+				for(sat = 0; sat < sp->u.sats.count; sat++) {
 					int pos = offset+4+(sat*SAT_PKG_LEN);
+					isi_gps_sat_t *s = &sp->u.sats.sat[sat];
 					proto_item *satitem = proto_tree_add_text(subtree, tvb, pos, SAT_PKG_LEN, "Satellite %d", sat);
 					proto_tree *sattree = proto_item_add_subtree(satitem, ett_isi_msg);
 
-					float signal_strength = tvb_get_ntohs(tvb, pos+3) / 100.0;
-					float elevation       = tvb_get_ntohs(tvb, pos+6) / 100.0;
-					float azimuth         = tvb_get_ntohs(tvb, pos+8) / 100.0;
-
 					proto_tree_add_item(sattree, hf_isi_gps_prn,            tvb, pos+1, 1, FALSE);
 					proto_tree_add_item(sattree, hf_isi_gps_sat_used,       tvb, pos+2, 1, FALSE);
-					proto_tree_add_float(sattree, hf_isi_gps_sat_strength,  tvb, pos+3, 2, signal_strength);
-					proto_tree_add_float(sattree, hf_isi_gps_sat_elevation, tvb, pos+6, 2, elevation);
-					proto_tree_add_float(sattree, hf_isi_gps_sat_azimuth,   tvb, pos+8, 2, azimuth);
+					proto_tree_add_float(sattree, hf_isi_gps_sat_strength,  tvb, pos+3, 2, s->strength);
+					proto_tree_add_float(sattree, hf_isi_gps_sat_elevation, tvb, pos+6, 2, s->elevation);
+					proto_tree_add_float(sattree, hf_isi_gps_sat_azimuth,   tvb, pos+8, 2, s->azimuth);
 				}
 				break;
 			case 0x07: // CellInfo GSM
@@ -292,53 +506,51 @@ static void dissect_isi_gps_data(tvbuff_t *tvb, packet_info *pinfo, proto_item *
 			default:
 				break;
 		}
-
-		offset += splen - 4;
 	}
 
+	if(data->malformed)
+		isi_expert_add(pinfo, item, PI_MALFORMED, PI_ERROR, 0x54, 0x92, 0, "Malformed subpacket at offset %u", data->malformed_offset);
 }
 
-static void dissect_isi_gps(tvbuff_t *tvb, packet_info *pinfo, proto_item *isitree) {
-	proto_item *item = NULL;
-	proto_tree *tree = NULL;
-	guint8 cmd;
+static void dissect_isi_gps_status_ind(tvbuff_t *tvb, packet_info *pinfo, proto_item *item, proto_tree *tree) {
+	guint8 status = tvb_get_guint8(tvb, 2);
 
-	if(isitree) {
-		item = proto_tree_add_text(isitree, tvb, 0, -1, "Payload");
-		tree = proto_item_add_subtree(item, ett_isi_msg);
+	col_add_fstr(pinfo->cinfo, COL_INFO, "GPS Status Indication: %s", val_to_str(status, isi_gps_status, "unknown (0x%x)"));
+	proto_tree_add_item(tree, hf_isi_gps_status, tvb, 2, 1, FALSE);
+	isi_gps_tap_queue(tvb, pinfo, status, NULL);
+}
 
-		proto_tree_add_item(tree, hf_isi_gps_cmd, tvb, 0, 1, FALSE);
-		cmd = tvb_get_guint8(tvb, 0);
+static void dissect_isi_gps_agps(tvbuff_t *tvb, packet_info *pinfo, proto_item *item, proto_tree *tree) {
+	col_add_fstr(pinfo->cinfo, COL_INFO, "unknown A-GPS packet (0x%02x)", tvb_get_guint8(tvb, 0));
+}
 
-		switch(cmd) {
-			case 0x7d: /* GPS Status */
-				proto_tree_add_item(tree, hf_isi_gps_status, tvb, 2, 1, FALSE);
-				guint8 status = tvb_get_guint8(tvb, 2);
-				col_add_fstr(pinfo->cinfo, COL_INFO, "GPS Status Indication: %s", val_to_str(status, isi_gps_status, "unknown (0x%x)"));
-				break;
-			case 0x84:
-			case 0x85:
-			case 0x86:
-			case 0x87:
-			case 0x88:
-			case 0x89:
-			case 0x8a:
-			case 0x8b:
-				col_add_fstr(pinfo->cinfo, COL_INFO, "unknown A-GPS packet (0x%02x)", cmd);
-				break;
-			case 0x90: /* GPS Power Request */
-				col_set_str(pinfo->cinfo, COL_INFO, "GPS Power Request");
-				break;
-			case 0x91: /* GPS Power Request */
-				col_set_str(pinfo->cinfo, COL_INFO, "GPS Power Response");
-				break;
-			case 0x92: /* GPS Data */
-				col_set_str(pinfo->cinfo, COL_INFO, "GPS Data");
-				dissect_isi_gps_data(tvb, pinfo, item, tree);
-				break;
-			default:
-				col_add_fstr(pinfo->cinfo, COL_INFO, "unknown GPS packet (0x%02x)", cmd);
-				break;
-		}
+static void dissect_isi_gps_power_status_req(tvbuff_t *tvb, packet_info *pinfo, proto_item *item, proto_tree *tree) {
+	col_set_str(pinfo->cinfo, COL_INFO, "GPS Power Request");
+	isi_gps_tap_queue(tvb, pinfo, 0, NULL);
+}
+
+static void dissect_isi_gps_power_status_rsp(tvbuff_t *tvb, packet_info *pinfo, proto_item *item, proto_tree *tree) {
+	col_set_str(pinfo->cinfo, COL_INFO, "GPS Power Response");
+	isi_gps_tap_queue(tvb, pinfo, 0, NULL);
+}
+
+static void dissect_isi_gps_unknown(tvbuff_t *tvb, packet_info *pinfo, proto_item *item, proto_tree *tree) {
+	col_add_fstr(pinfo->cinfo, COL_INFO, "unknown GPS packet (0x%02x)", tvb_get_guint8(tvb, 0));
+}
+
+void proto_reg_handoff_isi_gps(void) {
+	static gboolean initialized=FALSE;
+	guint8 cmd;
+
+	if (!initialized) {
+		isi_register_resource(0x54, &hf_isi_gps_cmd, dissect_isi_gps_unknown);
+		isi_register_message(0x54, 0x7d, dissect_isi_gps_status_ind);
+		for(cmd = 0x84; cmd <= 0x8b; cmd++)
+			isi_register_message(0x54, cmd, dissect_isi_gps_agps);
+		isi_register_message(0x54, 0x90, dissect_isi_gps_power_status_req);
+		isi_register_message(0x54, 0x91, dissect_isi_gps_power_status_rsp);
+		isi_register_message(0x54, 0x92, dissect_isi_gps_data);
+
+		isi_register_transaction(0x54, 0x90, 0x91);
 	}
 }
@@ -1,7 +1,60 @@
-#ifndef _ISI_SIMAUTH_H
-#define _ISI_SIMAUTH_H
+#ifndef _ISI_GPS_H
+#define _ISI_GPS_H
 
 void proto_reg_handoff_isi_gps(void);
 void proto_register_isi_gps(void);
 
+#define ISI_GPS_STATUS_IND		0x7d
+#define ISI_GPS_POWER_STATUS_REQ	0x90
+#define ISI_GPS_POWER_STATUS_RSP	0x91
+#define ISI_GPS_DATA_IND		0x92
+
+/* GPS_STATUS_IND states */
+#define ISI_GPS_DISABLED		0x00
+#define ISI_GPS_NO_LOCK			0x01
+#define ISI_GPS_LOCK			0x02
+
+/* one satellite of GPS_SAT_INFO */
+typedef struct _isi_gps_sat_t {
+	guint8 prn;
+	gboolean used;
+	float strength;
+	float elevation;	/* degree */
+	float azimuth;		/* degree */
+} isi_gps_sat_t;
+
+/* Data of the "isi.gps" tap, queued for GPS_STATUS_IND, the power
+ * status messages and GPS_DATA_IND */
+typedef struct _isi_gps_tap_info_t {
+	guint8 msg_id;
+	guint8 status;		/* status indication only */
+	gboolean has_position;	/* data indication with a valid position */
+	double lat;
+	double lon;
+	float eph;		/* meter */
+	gint32 altitude;	/* meter */
+	float epv;		/* meter */
+	gboolean has_time;	/* UTC from the GPS_TIME_DATE subpacket */
+	guint16 year;
+	guint8 month;
+	guint8 day;
+	guint8 hour;
+	guint8 minute;
+	float second;
+	gboolean has_movement;
+	float course;		/* degree */
+	float speed;		/* km/h */
+	float climb;		/* km/h */
+	gboolean has_satellites;
+	guint8 satellites;
+	guint8 satellites_used;
+	const isi_gps_sat_t *sat;	/* 'satellites' entries */
+	gboolean has_cell;	/* GPS_CELL_INFO_GSM or GPS_CELL_INFO_WCDMA */
+	gboolean wcdma;
+	guint16 mcc;
+	guint16 mnc;
+	guint16 lac;		/* GSM only */
+	guint32 cid;
+} isi_gps_tap_info_t;
+
 #endif
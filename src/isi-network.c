@@ -19,9 +19,12 @@
 # include "config.h"
 #endif
 
+#include <string.h>
 #include <glib.h>
 #include <epan/prefs.h>
 #include <epan/packet.h>
+#include <epan/emem.h>
+#include <epan/tap.h>
 
 #include "packet-isi.h"
 #include "isi-network.h"
@@ -47,6 +50,7 @@ static const value_string isi_network_id[] = {
 	{0xF0, "NET_COMMON_MESSAGE"},
 	{0x00, NULL}
 };
+static value_string_ext isi_network_id_ext = VALUE_STRING_EXT_INIT(isi_network_id);
 
 static const value_string isi_network_status_sub_id[] = {
 	{0x00, "NET_REG_INFO_COMMON"},
@@ -62,6 +66,27 @@ static const value_string isi_network_status_sub_id[] = {
 	{0x00, NULL}
 };
 
+static const value_string isi_network_reg_status[] = {
+	{0x00, "NET_REG_STATUS_HOME"},
+	{0x01, "NET_REG_STATUS_ROAM"},
+	{0x02, "NET_REG_STATUS_ROAM_BLINK"},
+	{0x03, "NET_REG_STATUS_NOSERV"},
+	{0x04, "NET_REG_STATUS_NOSERV_SEARCHING"},
+	{0x05, "NET_REG_STATUS_NOSERV_NOTSEARCHING"},
+	{0x06, "NET_REG_STATUS_NOSERV_NOSIM"},
+	{0x08, "NET_REG_STATUS_POWER_OFF"},
+	{0x09, "NET_REG_STATUS_NSPS"},
+	{0x0A, "NET_REG_STATUS_NSPS_NO_COVERAGE"},
+	{0x0B, "NET_REG_STATUS_NOSERV_SIM_REJECTED_BY_NW"},
+	{0x00, NULL}
+};
+
+static const value_string isi_network_rat_name[] = {
+	{0x01, "NET_GSM_RAT"},
+	{0x02, "NET_UMTS_RAT"},
+	{0x00, NULL}
+};
+
 static const value_string isi_network_cell_info_sub_id[] = {
 	{0x46, "NET_GSM_CELL_INFO"},
 	{0x47, "NET_WCDMA_CELL_INFO"},
@@ -69,9 +94,6 @@ static const value_string isi_network_cell_info_sub_id[] = {
 	{0x00, NULL}
 };
 
-static dissector_handle_t isi_network_handle;
-static void dissect_isi_network(tvbuff_t *tvb, packet_info *pinfo, proto_item *tree);
-
 static guint32 hf_isi_network_cmd = -1;
 static guint32 hf_isi_network_data_sub_pkgs = -1;
 static guint32 hf_isi_network_status_sub_type = -1;
@@ -87,6 +109,16 @@ static guint32 hf_isi_network_gsm_band_900 = -1;
 static guint32 hf_isi_network_gsm_band_1800 = -1;
 static guint32 hf_isi_network_gsm_band_1900 = -1;
 static guint32 hf_isi_network_gsm_band_850 = -1;
+static guint32 hf_isi_network_reg_status = -1;
+static guint32 hf_isi_network_rat = -1;
+static guint32 hf_isi_network_prev_lac = -1;
+static guint32 hf_isi_network_prev_cid = -1;
+static guint32 hf_isi_network_time_in_cell = -1;
+static guint32 hf_isi_network_prev_cell_time = -1;
+static guint32 hf_isi_network_rssi_bars = -1;
+static guint32 hf_isi_network_rssi_dbm = -1;
+
+static int isi_network_tap = -1;
 
 static const int *gsm_band_fields[] = {
 	&hf_isi_network_gsm_band_900,
@@ -96,19 +128,33 @@ static const int *gsm_band_fields[] = {
 	NULL
 };
 
-void proto_reg_handoff_isi_network(void) {
-	static gboolean initialized=FALSE;
+const gchar *isi_network_rat_str(guint8 rat) {
+	return val_to_str_const(rat, isi_network_rat_name, "Unknown");
+}
 
-	if (!initialized) {
-		isi_network_handle = create_dissector_handle(dissect_isi_network, proto_isi);
-		dissector_add("isi.resource", 0x0a, isi_network_handle);
-	}
+const gchar *isi_network_reg_status_str(guint8 status) {
+	return val_to_str_const(status, isi_network_reg_status, "Unknown");
+}
+
+/* Serving cell on the first pass, in capture order */
+static struct {
+	gboolean valid;
+	guint16 lac;
+	guint32 cid;
+	nstime_t entered;
+	gboolean prev_valid;
+	guint16 prev_lac;
+	guint32 prev_cid;
+} isi_network_cell;
+
+static void isi_network_init(void) {
+	memset(&isi_network_cell, 0, sizeof(isi_network_cell));
 }
 
 void proto_register_isi_network(void) {
 	static hf_register_info hf[] = {
 		{ &hf_isi_network_cmd,
-		  { "Command", "isi.network.cmd", FT_UINT8, BASE_HEX, isi_network_id, 0x0, "Command", HFILL }},
+		  { "Command", "isi.network.cmd", FT_UINT8, BASE_HEX|BASE_EXT_STRING, &isi_network_id_ext, 0x0, "Command", HFILL }},
 		{ &hf_isi_network_data_sub_pkgs,
 		  { "Number of Subpackets", "isi.network.pkgs", FT_UINT8, BASE_DEC, NULL, 0x0, "Number of Subpackets", HFILL }},
 		{ &hf_isi_network_status_sub_type,
@@ -136,49 +182,247 @@ void proto_register_isi_network(void) {
 		{ &hf_isi_network_gsm_band_1900,
 		  { "1900 Mhz Band", "isi.network.sub.gsm_band_1900", FT_BOOLEAN, 32, NULL, 0x00000004, "", HFILL }},
 		{ &hf_isi_network_gsm_band_850,
-		  { "850 Mhz Band", "isi.network.sub.gsm_band_850", FT_BOOLEAN, 32, NULL, 0x00000008, "", HFILL }}
+		  { "850 Mhz Band", "isi.network.sub.gsm_band_850", FT_BOOLEAN, 32, NULL, 0x00000008, "", HFILL }},
+		{ &hf_isi_network_reg_status,
+		  { "Registration Status", "isi.network.sub.reg_status", FT_UINT8, BASE_HEX, isi_network_reg_status, 0x0, "Registration Status", HFILL }},
+		{ &hf_isi_network_rat,
+		  { "Radio Access Technology", "isi.network.sub.rat", FT_UINT8, BASE_HEX, isi_network_rat_name, 0x0, "Radio Access Technology", HFILL }},
+		{ &hf_isi_network_prev_lac,
+		  { "Previous LAC", "isi.network.prev_lac", FT_UINT16, BASE_HEX_DEC, NULL, 0x0, "Location Area Code of the previous serving cell", HFILL }},
+		{ &hf_isi_network_prev_cid,
+		  { "Previous Cell ID", "isi.network.prev_cid", FT_UINT32, BASE_HEX_DEC, NULL, 0x0, "Cell ID of the previous serving cell", HFILL }},
+		{ &hf_isi_network_time_in_cell,
+		  { "Time in Cell", "isi.network.time_in_cell", FT_RELATIVE_TIME, BASE_NONE, NULL, 0x0, "Time since the serving cell was entered", HFILL }},
+		{ &hf_isi_network_prev_cell_time,
+		  { "Time in Previous Cell", "isi.network.prev_cell_time", FT_RELATIVE_TIME, BASE_NONE, NULL, 0x0, "Time spent in the previous serving cell", HFILL }},
+		{ &hf_isi_network_rssi_bars,
+		  { "Signal Strength (%)", "isi.network.rssi_bars", FT_UINT8, BASE_DEC, NULL, 0x0, "Signal Strength in percent of the bar display", HFILL }},
+		{ &hf_isi_network_rssi_dbm,
+		  { "Signal Strength (dBm)", "isi.network.rssi_dbm", FT_INT16, BASE_DEC, NULL, 0x0, "Signal Strength in dBm", HFILL }}
 	};
 
 	proto_register_field_array(proto_isi, hf, array_length(hf));
-	register_dissector("isi.network", dissect_isi_network, proto_isi);
+	register_init_routine(isi_network_init);
+	isi_network_tap = register_tap("isi.network");
 }
 
-/* would be nice if wireshark could handle unicode... */
-static void* utf16_to_ascii(char *in, guint16 len) {
-	char *out = malloc(len+1);
+/* parsed subpacket chain of NET_REG_STATUS_IND and NET_CELL_INFO_IND,
+ * cached per frame */
+typedef struct _isi_network_subpkg_t {
+	guint offset;
+	guint8 type;
+	guint8 len;
+	guint16 msglen;
+	const char *msg;
+} isi_network_subpkg_t;
+
+typedef struct _isi_network_data_t {
+	guint8 count;
+	gboolean malformed;
+	guint malformed_offset;
+	isi_network_subpkg_t *pkg;
+
+	/* state carried by the subpackets */
+	isi_network_tap_info_t state;
+
+	/* serving cell history at this message */
+	gboolean has_prev;
+	guint16 prev_lac;
+	guint32 prev_cid;
+	nstime_t entered;		/* current cell entered */
+	gboolean changed;
+	nstime_t prev_time;		/* time in the previous cell, if changed */
+} isi_network_data_t;
+
+/* bytes a subpacket needs for the fields added to the tree */
+static guint8 isi_network_subpkg_need(guint8 type) {
+	switch(type) {
+		case 0x00: return 2 + 1;	// NET_REG_INFO_COMMON
+		case 0x04: return 2 + 2;	// NET_RSSI_CURRENT
+		case 0x09: return 2 + 8;	// NET_GSM_REG_INFO
+		case 0x2C: return 2 + 1;	// NET_RAT_INFO
+		case 0x46: return 2 + 13;	// NET_GSM_CELL_INFO
+		case 0xe3: return 2 + 4;
+		default:   return 2;
+	}
+}
 
-	int i;
-	for(i=0; i<len; i++) {
-		out[i] = in[(i*2)+1];
+static isi_network_data_t *isi_network_parse_subpkgs(tvbuff_t *tvb) {
+	isi_network_data_t *data = se_new0(isi_network_data_t);
+	isi_subblock_iter_t it;
+
+	if(tvb_length(tvb) < 0x03) {
+		data->malformed = TRUE;
+		return data;
 	}
 
-	out[len] = 0x00;
+	// subpackets start at 0x03
+	isi_subblock_iter_init(&it, tvb, 0x03, tvb_get_guint8(tvb, 0x02), 2, 0, 1);
+	data->pkg = se_alloc0(it.count * sizeof(isi_network_subpkg_t));
 
-	return out;
+	while(isi_subblock_iter_next(&it)) {
+		isi_network_subpkg_t *sp = &data->pkg[data->count++];
+
+		sp->offset = it.block_offset;
+		sp->type = it.type;
+		sp->len = it.len;
+
+		switch(sp->type) {
+			case 0x00: // NET_REG_INFO_COMMON
+				if(sp->len >= 3) {
+					data->state.has_reg = TRUE;
+					data->state.reg_status = tvb_get_guint8(tvb, sp->offset+2);
+				}
+				break;
+			case 0x09: // NET_GSM_REG_INFO
+			case 0x46: // NET_GSM_CELL_INFO
+				if(sp->len >= isi_network_subpkg_need(sp->type)) {
+					data->state.has_cell = TRUE;
+					data->state.lac = tvb_get_ntohs(tvb, sp->offset+2);
+					data->state.cid = tvb_get_ntohl(tvb, sp->offset+(sp->type == 0x09 ? 6 : 4));
+				}
+				if(sp->type == 0x46 && sp->len >= isi_network_subpkg_need(sp->type)) {
+					data->state.has_operator = TRUE;
+					data->state.bands = tvb_get_ntohl(tvb, sp->offset+8);
+					tvb_memcpy(tvb, data->state.operator_code, sp->offset+12, 3);
+				}
+				break;
+			case 0x2C: // NET_RAT_INFO
+				if(sp->len >= 3) {
+					data->state.has_rat = TRUE;
+					data->state.rat = tvb_get_guint8(tvb, sp->offset+2);
+				}
+				break;
+			case 0x04: // NET_RSSI_CURRENT
+				if(sp->len >= isi_network_subpkg_need(sp->type)) {
+					data->state.has_rssi = TRUE;
+					data->state.rssi_bars = tvb_get_guint8(tvb, sp->offset+2);
+					data->state.rssi_dbm = -tvb_get_guint8(tvb, sp->offset+3);
+				}
+				break;
+		}
+
+		/* FIXME: TODO: byte 0: message type (provider name / network name) ? */
+		if(sp->type == 0xe3 && sp->len >= 6) {
+			sp->msglen = tvb_get_ntohs(tvb, sp->offset+4);
+
+			if(6 + sp->msglen*2 <= sp->len)
+				sp->msg = isi_ucs2_intern(tvb, sp->offset+6, sp->msglen);
+		}
+	}
+
+	data->malformed = it.malformed;
+	data->malformed_offset = it.offset;
+
+	return data;
+}
+
+/* Follows the serving cell. Runs once per message when it is parsed,
+ * which happens on the first pass, in capture order. */
+static void isi_network_track_cell(isi_network_data_t *data, packet_info *pinfo) {
+	if(!data->state.has_cell)
+		return;
+
+	if(isi_network_cell.valid && (isi_network_cell.lac != data->state.lac || isi_network_cell.cid != data->state.cid)) {
+		data->changed = TRUE;
+		nstime_delta(&data->prev_time, &pinfo->fd->abs_ts, &isi_network_cell.entered);
+
+		isi_network_cell.prev_valid = TRUE;
+		isi_network_cell.prev_lac = isi_network_cell.lac;
+		isi_network_cell.prev_cid = isi_network_cell.cid;
+		isi_network_cell.valid = FALSE;
+	}
+
+	if(!isi_network_cell.valid) {
+		isi_network_cell.valid = TRUE;
+		isi_network_cell.lac = data->state.lac;
+		isi_network_cell.cid = data->state.cid;
+		isi_network_cell.entered = pinfo->fd->abs_ts;
+	}
+
+	data->entered = isi_network_cell.entered;
+	data->has_prev = isi_network_cell.prev_valid;
+	data->prev_lac = isi_network_cell.prev_lac;
+	data->prev_cid = isi_network_cell.prev_cid;
+}
+
+static isi_network_data_t *isi_network_get_subpkgs(tvbuff_t *tvb, packet_info *pinfo) {
+	isi_network_data_t *data = isi_get_frame_data(pinfo, tvb);
+
+	if(!data) {
+		data = isi_network_parse_subpkgs(tvb);
+		isi_network_track_cell(data, pinfo);
+		isi_add_frame_data(pinfo, tvb, data);
+	}
+
+	if(have_tap_listener(isi_network_tap) && (data->state.has_cell || data->state.has_rat || data->state.has_reg || data->state.has_rssi))
+		tap_queue_packet(isi_network_tap, pinfo, &data->state);
+
+	return data;
+}
+
+static void isi_network_add_cell_items(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, isi_network_data_t *data) {
+	proto_item *ti;
+	nstime_t delta;
+
+	if(!data->state.has_cell)
+		return;
+
+	if(data->has_prev) {
+		ti = proto_tree_add_uint(tree, hf_isi_network_prev_lac, tvb, 0, 0, data->prev_lac);
+		PROTO_ITEM_SET_GENERATED(ti);
+		ti = proto_tree_add_uint(tree, hf_isi_network_prev_cid, tvb, 0, 0, data->prev_cid);
+		PROTO_ITEM_SET_GENERATED(ti);
+	}
+
+	if(data->changed) {
+		ti = proto_tree_add_time(tree, hf_isi_network_prev_cell_time, tvb, 0, 0, &data->prev_time);
+		PROTO_ITEM_SET_GENERATED(ti);
+	}
+
+	nstime_delta(&delta, &pinfo->fd->abs_ts, &data->entered);
+	ti = proto_tree_add_time(tree, hf_isi_network_time_in_cell, tvb, 0, 0, &delta);
+	PROTO_ITEM_SET_GENERATED(ti);
 }
 
 static void dissect_isi_network_status(tvbuff_t *tvb, packet_info *pinfo, proto_item *item, proto_tree *tree) {
-	guint8 len = tvb->length;
+	isi_network_data_t *data;
 	int i;
 
-	guint8 pkgcount = tvb_get_guint8(tvb, 0x02);
+	col_set_str(pinfo->cinfo, COL_INFO, "Network Status Indication");
+
+	/* parsed without a tree as well, the cell tracking needs every message */
+	data = isi_network_get_subpkgs(tvb, pinfo);
+	if(!tree)
+		return;
+
+	if(tvb_length(tvb) < 0x03) {
+		isi_expert_add(pinfo, item, PI_MALFORMED, PI_ERROR, 0x0a, 0xE2, 0, "Message too short");
+		return;
+	}
+
 	proto_tree_add_item(tree, hf_isi_network_data_sub_pkgs, tvb, 0x02, 1, FALSE);
 
-	size_t offset = 0x03; // subpackets start here
-	for(i=0; i<pkgcount; i++) {
-		guint8 sptype = tvb_get_guint8(tvb, offset+0);
-		guint8 splen = tvb_get_guint8(tvb, offset+1);
+	for(i=0; i<data->count; i++) {
+		isi_network_subpkg_t *sp = &data->pkg[i];
+		guint offset = sp->offset;
 
-		proto_item *subitem = proto_tree_add_text(tree, tvb, offset, splen, "Subpacket (%s)", val_to_str(sptype, isi_network_status_sub_id, "unknown: 0x%x"));
+		proto_item *subitem = proto_tree_add_text(tree, tvb, offset, sp->len, "Subpacket (%s)", val_to_str(sp->type, isi_network_status_sub_id, "unknown: 0x%x"));
 		proto_tree *subtree = proto_item_add_subtree(subitem, ett_isi_msg);
 
 		proto_tree_add_item(subtree, hf_isi_network_status_sub_type, tvb, offset+0, 1, FALSE);
 		proto_tree_add_item(subtree, hf_isi_network_status_sub_len, tvb,  offset+1, 1, FALSE);
 
+		if(sp->len < isi_network_subpkg_need(sp->type)) {
+			isi_expert_add(pinfo, subitem, PI_MALFORMED, PI_ERROR, 0x0a, 0xE2, sp->type, "Subpacket too short (%d bytes)", sp->len);
+			continue;
+		}
+
 		offset += 2;
 
-		switch(sptype) {
+		switch(sp->type) {
 			case 0x00: // NET_REG_INFO_COMMON
+				proto_tree_add_item(subtree, hf_isi_network_reg_status, tvb, offset+0, 1, FALSE);
 				/* FIXME: TODO */
 				break;
 			case 0x09: // NET_GSM_REG_INFO
@@ -186,49 +430,69 @@ static void dissect_isi_network_status(tvbuff_t *tvb, packet_info *pinfo, proto_
 				proto_tree_add_item(subtree, hf_isi_network_status_sub_cid, tvb, offset+4, 4, FALSE);
 				/* FIXME: TODO */
 				break;
-			case 0xe3: ; // UNKNOWN
-				/* FIXME: TODO: byte 0: message type (provider name / network name) ? */
-
-				guint16 strlen = tvb_get_ntohs(tvb, offset+2);
+			case 0x04: // NET_RSSI_CURRENT
+				proto_tree_add_item(subtree, hf_isi_network_rssi_bars, tvb, offset+0, 1, FALSE);
+				proto_tree_add_int(subtree, hf_isi_network_rssi_dbm, tvb, offset+1, 1, -tvb_get_guint8(tvb, offset+1));
+				break;
+			case 0x2C: // NET_RAT_INFO
+				proto_tree_add_item(subtree, hf_isi_network_rat, tvb, offset+0, 1, FALSE);
+				break;
+			case 0xe3: // UNKNOWN
 				proto_tree_add_item(subtree, hf_isi_network_status_sub_msg_len, tvb, offset+2, 2, FALSE);
-
-				char *utf16 = tvb_memdup(tvb, offset+4, strlen*2);
-				char *ascii = utf16_to_ascii(utf16, strlen);
-				proto_item *subitem = proto_tree_add_string(subtree, hf_isi_network_status_sub_msg, tvb, offset+4, strlen*2, ascii);
+				if(sp->msg)
+					proto_tree_add_string(subtree, hf_isi_network_status_sub_msg, tvb, offset+4, sp->msglen*2, sp->msg);
+				else
+					isi_expert_add(pinfo, subitem, PI_MALFORMED, PI_ERROR, 0x0a, 0xE2, sp->type, "Message exceeds subpacket");
 				break;
 			default:
 				break;
 		}
-
-		offset += splen - 2;
 	}
+
+	if(data->malformed)
+		isi_expert_add(pinfo, item, PI_MALFORMED, PI_ERROR, 0x0a, 0xE2, 0, "Malformed subpacket at offset %u", data->malformed_offset);
+
+	isi_network_add_cell_items(tvb, pinfo, tree, data);
 }
 
 static void dissect_isi_network_cell_info_ind(tvbuff_t *tvb, packet_info *pinfo, proto_item *item, proto_tree *tree) {
-	guint8 len = tvb->length;
+	isi_network_data_t *data;
 	int i;
 
-	guint8 pkgcount = tvb_get_guint8(tvb, 0x02);
-	proto_tree_add_item(tree, hf_isi_network_data_sub_pkgs, tvb, 0x02, 1, FALSE);
+	col_set_str(pinfo->cinfo, COL_INFO, "Network Cell Info Indication");
 
-	size_t offset = 0x03;
+	data = isi_network_get_subpkgs(tvb, pinfo);
+	if(!tree)
+		return;
 
-	for(i=0; i<pkgcount; i++) {
-		guint8 sptype = tvb_get_guint8(tvb, offset+0);
-		guint8 splen = tvb_get_guint8(tvb, offset+1);
+	if(tvb_length(tvb) < 0x03) {
+		isi_expert_add(pinfo, item, PI_MALFORMED, PI_ERROR, 0x0a, 0x42, 0, "Message too short");
+		return;
+	}
 
-		proto_item *subitem = proto_tree_add_text(tree, tvb, offset, splen, "Subpacket (%s)", val_to_str(sptype, isi_network_cell_info_sub_id, "unknown: 0x%x"));
+	proto_tree_add_item(tree, hf_isi_network_data_sub_pkgs, tvb, 0x02, 1, FALSE);
+
+	for(i=0; i<data->count; i++) {
+		isi_network_subpkg_t *sp = &data->pkg[i];
+		guint offset = sp->offset;
+
+		proto_item *subitem = proto_tree_add_text(tree, tvb, offset, sp->len, "Subpacket (%s)", val_to_str(sp->type, isi_network_cell_info_sub_id, "unknown: 0x%x"));
 		proto_tree *subtree = proto_item_add_subtree(subitem, ett_isi_msg);
 
 		proto_tree_add_item(subtree, hf_isi_network_cell_info_sub_type, tvb, offset+0, 1, FALSE);
 		proto_tree_add_item(subtree, hf_isi_network_cell_info_sub_len, tvb,  offset+1, 1, FALSE);
 
+		if(sp->len < isi_network_subpkg_need(sp->type)) {
+			isi_expert_add(pinfo, subitem, PI_MALFORMED, PI_ERROR, 0x0a, 0x42, sp->type, "Subpacket too short (%d bytes)", sp->len);
+			continue;
+		}
+
 		offset += 2;
 
-		switch(sptype) {
+		switch(sp->type) {
 			case 0x50: // NET_EPS_CELL_INFO
 				/* TODO: not yet implemented */
-				expert_add_info_format(pinfo, item, PI_PROTOCOL, PI_WARN, "unsupported packet");
+				isi_expert_add(pinfo, item, PI_PROTOCOL, PI_WARN, 0x0a, 0x42, sp->type, "unsupported packet");
 				break;
 			case 0x46: // NET_GSM_CELL_INFO
 				proto_tree_add_item(subtree, hf_isi_network_status_sub_lac, tvb, offset+0, 2, FALSE);
@@ -239,50 +503,182 @@ static void dissect_isi_network_cell_info_ind(tvbuff_t *tvb, packet_info *pinfo,
 				break;
 			case 0x47: // NET_WCDMA_CELL_INFO
 				/* TODO: not yet implemented */
-				expert_add_info_format(pinfo, item, PI_PROTOCOL, PI_WARN, "unsupported packet");
+				isi_expert_add(pinfo, item, PI_PROTOCOL, PI_WARN, 0x0a, 0x42, sp->type, "unsupported packet");
 				break;
 			default:
-				expert_add_info_format(pinfo, item, PI_PROTOCOL, PI_WARN, "unsupported packet");
+				isi_expert_add(pinfo, item, PI_PROTOCOL, PI_WARN, 0x0a, 0x42, sp->type, "unsupported packet");
 				break;
 		}
+	}
+
+	if(data->malformed)
+		isi_expert_add(pinfo, item, PI_MALFORMED, PI_ERROR, 0x0a, 0x42, 0, "Malformed subpacket at offset %u", data->malformed_offset);
+
+	isi_network_add_cell_items(tvb, pinfo, tree, data);
+}
+
+static void dissect_isi_network_rat_ind(tvbuff_t *tvb, packet_info *pinfo, proto_item *item, proto_tree *tree) {
+	isi_network_data_t *data;
+	int i;
+
+	col_set_str(pinfo->cinfo, COL_INFO, "Network RAT Indication");
+
+	data = isi_network_get_subpkgs(tvb, pinfo);
+	if(data->state.has_rat)
+		col_append_fstr(pinfo->cinfo, COL_INFO, ": %s", val_to_str(data->state.rat, isi_network_rat_name, "unknown: 0x%x"));
+
+	if(!tree)
+		return;
+
+	if(tvb_length(tvb) < 0x03) {
+		isi_expert_add(pinfo, item, PI_MALFORMED, PI_ERROR, 0x0a, 0x35, 0, "Message too short");
+		return;
+	}
+
+	proto_tree_add_item(tree, hf_isi_network_data_sub_pkgs, tvb, 0x02, 1, FALSE);
+
+	for(i=0; i<data->count; i++) {
+		isi_network_subpkg_t *sp = &data->pkg[i];
+
+		proto_item *subitem = proto_tree_add_text(tree, tvb, sp->offset, sp->len, "Subpacket (%s)", val_to_str(sp->type, isi_network_status_sub_id, "unknown: 0x%x"));
+		proto_tree *subtree = proto_item_add_subtree(subitem, ett_isi_msg);
+
+		proto_tree_add_item(subtree, hf_isi_network_status_sub_type, tvb, sp->offset+0, 1, FALSE);
+		proto_tree_add_item(subtree, hf_isi_network_status_sub_len, tvb,  sp->offset+1, 1, FALSE);
+
+		if(sp->type != 0x2C) {
+			isi_expert_add(pinfo, subitem, PI_PROTOCOL, PI_WARN, 0x0a, 0x35, sp->type, "unsupported packet");
+			continue;
+		}
 
-		offset += splen - 2;
+		if(sp->len < isi_network_subpkg_need(sp->type)) {
+			isi_expert_add(pinfo, subitem, PI_MALFORMED, PI_ERROR, 0x0a, 0x35, sp->type, "Subpacket too short (%d bytes)", sp->len);
+			continue;
+		}
+
+		proto_tree_add_item(subtree, hf_isi_network_rat, tvb, sp->offset+2, 1, FALSE);
 	}
+
+	if(data->malformed)
+		isi_expert_add(pinfo, item, PI_MALFORMED, PI_ERROR, 0x0a, 0x35, 0, "Malformed subpacket at offset %u", data->malformed_offset);
 }
 
-static void dissect_isi_network(tvbuff_t *tvb, packet_info *pinfo, proto_item *isitree) {
-	proto_item *item = NULL;
-	proto_tree *tree = NULL;
-	guint8 cmd, code;
+static void dissect_isi_network_rssi_ind(tvbuff_t *tvb, packet_info *pinfo, proto_item *item, proto_tree *tree) {
+	isi_network_tap_info_t *info;
+	guint8 bars, dbm;
+
+	col_set_str(pinfo->cinfo, COL_INFO, "Network RSSI Indication");
 
-	if(isitree) {
-		item = proto_tree_add_text(isitree, tvb, 0, -1, "Payload");
-		tree = proto_item_add_subtree(item, ett_isi_msg);
+	if(tvb_length(tvb) < 3) {
+		if(tree)
+			isi_expert_add(pinfo, item, PI_MALFORMED, PI_ERROR, 0x0a, 0x1E, 0, "Message too short");
+		return;
+	}
 
-		proto_tree_add_item(tree, hf_isi_network_cmd, tvb, 0, 1, FALSE);
-		cmd = tvb_get_guint8(tvb, 0);
+	bars = tvb_get_guint8(tvb, 1);
+	dbm = tvb_get_guint8(tvb, 2);
+	col_append_fstr(pinfo->cinfo, COL_INFO, ": %u%%, -%u dBm", bars, dbm);
 
-		switch(cmd) {
-			case 0x07:
-				col_set_str(pinfo->cinfo, COL_INFO, "Network Selection Request");
-				expert_add_info_format(pinfo, item, PI_PROTOCOL, PI_WARN, "unsupported packet");
-				break;
-			case 0x20:
-				col_set_str(pinfo->cinfo, COL_INFO, "Network Ciphering Indication");
-				expert_add_info_format(pinfo, item, PI_PROTOCOL, PI_WARN, "unsupported packet");
-				break;
-			case 0xE2:
-				col_set_str(pinfo->cinfo, COL_INFO, "Network Status Indication");
-				dissect_isi_network_status(tvb, pinfo, item, tree);
-				break;
-			case 0x42:
-				col_set_str(pinfo->cinfo, COL_INFO, "Network Cell Info Indication");
-				dissect_isi_network_cell_info_ind(tvb, pinfo, item, tree);
-				break;
-			default:
-				col_set_str(pinfo->cinfo, COL_INFO, "unknown Network packet");
-				expert_add_info_format(pinfo, item, PI_PROTOCOL, PI_WARN, "unsupported packet");
-				break;
+	if(tree) {
+		proto_tree_add_item(tree, hf_isi_network_rssi_bars, tvb, 1, 1, FALSE);
+		proto_tree_add_int(tree, hf_isi_network_rssi_dbm, tvb, 2, 1, -dbm);
+	}
+
+	if(have_tap_listener(isi_network_tap)) {
+		info = ep_alloc0(sizeof(isi_network_tap_info_t));
+		info->has_rssi = TRUE;
+		info->rssi_bars = bars;
+		info->rssi_dbm = -dbm;
+		tap_queue_packet(isi_network_tap, pinfo, info);
+	}
+}
+
+static void dissect_isi_network_rssi_get_resp(tvbuff_t *tvb, packet_info *pinfo, proto_item *item, proto_tree *tree) {
+	isi_network_data_t *data;
+	int i;
+
+	col_set_str(pinfo->cinfo, COL_INFO, "Network RSSI Get Response");
+
+	data = isi_network_get_subpkgs(tvb, pinfo);
+	if(data->state.has_rssi)
+		col_append_fstr(pinfo->cinfo, COL_INFO, ": %u%%, %d dBm", data->state.rssi_bars, data->state.rssi_dbm);
+
+	if(!tree)
+		return;
+
+	if(tvb_length(tvb) < 0x03) {
+		isi_expert_add(pinfo, item, PI_MALFORMED, PI_ERROR, 0x0a, 0x0C, 0, "Message too short");
+		return;
+	}
+
+	proto_tree_add_item(tree, hf_isi_network_data_sub_pkgs, tvb, 0x02, 1, FALSE);
+
+	for(i=0; i<data->count; i++) {
+		isi_network_subpkg_t *sp = &data->pkg[i];
+
+		proto_item *subitem = proto_tree_add_text(tree, tvb, sp->offset, sp->len, "Subpacket (%s)", val_to_str(sp->type, isi_network_status_sub_id, "unknown: 0x%x"));
+		proto_tree *subtree = proto_item_add_subtree(subitem, ett_isi_msg);
+
+		proto_tree_add_item(subtree, hf_isi_network_status_sub_type, tvb, sp->offset+0, 1, FALSE);
+		proto_tree_add_item(subtree, hf_isi_network_status_sub_len, tvb,  sp->offset+1, 1, FALSE);
+
+		if(sp->type != 0x04) {
+			isi_expert_add(pinfo, subitem, PI_PROTOCOL, PI_WARN, 0x0a, 0x0C, sp->type, "unsupported packet");
+			continue;
+		}
+
+		if(sp->len < isi_network_subpkg_need(sp->type)) {
+			isi_expert_add(pinfo, subitem, PI_MALFORMED, PI_ERROR, 0x0a, 0x0C, sp->type, "Subpacket too short (%d bytes)", sp->len);
+			continue;
 		}
+
+		proto_tree_add_item(subtree, hf_isi_network_rssi_bars, tvb, sp->offset+2, 1, FALSE);
+		proto_tree_add_int(subtree, hf_isi_network_rssi_dbm, tvb, sp->offset+3, 1, -tvb_get_guint8(tvb, sp->offset+3));
+	}
+
+	if(data->malformed)
+		isi_expert_add(pinfo, item, PI_MALFORMED, PI_ERROR, 0x0a, 0x0C, 0, "Malformed subpacket at offset %u", data->malformed_offset);
+}
+
+static void dissect_isi_network_set_req(tvbuff_t *tvb, packet_info *pinfo, proto_item *item, proto_tree *tree) {
+	col_set_str(pinfo->cinfo, COL_INFO, "Network Selection Request");
+
+	if(tree)
+		isi_expert_add(pinfo, item, PI_PROTOCOL, PI_WARN, 0x0a, 0x07, 0, "unsupported packet");
+}
+
+static void dissect_isi_network_ciphering_ind(tvbuff_t *tvb, packet_info *pinfo, proto_item *item, proto_tree *tree) {
+	col_set_str(pinfo->cinfo, COL_INFO, "Network Ciphering Indication");
+
+	if(tree)
+		isi_expert_add(pinfo, item, PI_PROTOCOL, PI_WARN, 0x0a, 0x20, 0, "unsupported packet");
+}
+
+static void dissect_isi_network_unknown(tvbuff_t *tvb, packet_info *pinfo, proto_item *item, proto_tree *tree) {
+	col_set_str(pinfo->cinfo, COL_INFO, "unknown Network packet");
+
+	if(tree)
+		isi_expert_add(pinfo, item, PI_PROTOCOL, PI_WARN, 0x0a, tvb_get_guint8(tvb, 0), 0, "unsupported packet");
+}
+
+void proto_reg_handoff_isi_network(void) {
+	static gboolean initialized=FALSE;
+
+	if (!initialized) {
+		isi_register_resource(0x0a, &hf_isi_network_cmd, dissect_isi_network_unknown);
+		isi_register_message(0x0a, 0x07, dissect_isi_network_set_req);
+		isi_register_message(0x0a, 0x0C, dissect_isi_network_rssi_get_resp);
+		isi_register_message(0x0a, 0x1E, dissect_isi_network_rssi_ind);
+		isi_register_message(0x0a, 0x20, dissect_isi_network_ciphering_ind);
+		isi_register_message(0x0a, 0x35, dissect_isi_network_rat_ind);
+		isi_register_message(0x0a, 0x42, dissect_isi_network_cell_info_ind);
+		isi_register_message(0x0a, 0xE2, dissect_isi_network_status);
+
+		isi_register_transaction(0x0a, 0x07, 0x08);
+		isi_register_transaction(0x0a, 0x0B, 0x0C);
+		isi_register_transaction(0x0a, 0x36, 0x37);
+		isi_register_transaction(0x0a, 0xE0, 0xE1);
+		isi_register_transaction(0x0a, 0xE3, 0xE4);
+		isi_register_transaction(0x0a, 0xE5, 0xE6);
 	}
 }
@@ -1,7 +1,38 @@
-#ifndef _ISI_SIMAUTH_H
-#define _ISI_SIMAUTH_H
+#ifndef _ISI_NETWORK_H
+#define _ISI_NETWORK_H
 
 void proto_reg_handoff_isi_network(void);
 void proto_register_isi_network(void);
 
+/* NET_REG_INFO_COMMON registration states */
+#define ISI_NETWORK_REG_HOME		0x00
+#define ISI_NETWORK_REG_ROAM		0x01
+#define ISI_NETWORK_REG_ROAM_BLINK	0x02
+
+#define ISI_NETWORK_GSM_BAND_900	0x01
+#define ISI_NETWORK_GSM_BAND_1800	0x02
+#define ISI_NETWORK_GSM_BAND_1900	0x04
+#define ISI_NETWORK_GSM_BAND_850	0x08
+
+/* Data of the "isi.network" tap, queued for every message carrying
+ * serving cell, RAT, registration state or signal strength */
+typedef struct _isi_network_tap_info_t {
+	gboolean has_cell;
+	guint16 lac;
+	guint32 cid;
+	gboolean has_rat;
+	guint8 rat;
+	gboolean has_reg;
+	guint8 reg_status;
+	gboolean has_rssi;
+	guint8 rssi_bars;	/* percent */
+	gint16 rssi_dbm;
+	gboolean has_operator;	/* NET_GSM_CELL_INFO only */
+	guint8 operator_code[3];	/* BCD coded MCC/MNC as in 3GPP 24.008 */
+	guint32 bands;		/* ISI_NETWORK_GSM_BAND_*, 0 for all */
+} isi_network_tap_info_t;
+
+const gchar *isi_network_rat_str(guint8 rat);
+const gchar *isi_network_reg_status_str(guint8 status);
+
 #endif
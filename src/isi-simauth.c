@@ -38,8 +38,9 @@ static const value_string isi_sim_auth_id[] = {
 	{0x10, "SIM_AUTH_STATUS_IND"},
 	{0x11, "SIM_AUTH_STATUS_REQ"},
 	{0x12, "SIM_AUTH_STATUS_RESP"},
-	{0x00, NULL }
+	{0x00, NULL}
 };
+static value_string_ext isi_sim_auth_id_ext = VALUE_STRING_EXT_INIT(isi_sim_auth_id);
 
 static const value_string isi_sim_auth_pw_type[] = {
 	{0x02, "SIM_AUTH_PIN"},
@@ -79,9 +80,6 @@ static const value_string isi_sim_auth_indication_cfg[] = {
 	{0x00, NULL}
 };
 
-static dissector_handle_t isi_sim_auth_handle;
-static void dissect_isi_sim_auth(tvbuff_t *tvb, packet_info *pinfo, proto_item *tree);
-
 static guint32 hf_isi_sim_auth_cmd = -1;
 static guint32 hf_isi_sim_auth_status_rsp = -1;
 static guint32 hf_isi_sim_auth_protection_req = -1;
@@ -93,19 +91,10 @@ static guint32 hf_isi_sim_auth_pw_type = -1;
 static guint32 hf_isi_sim_auth_indication = -1;
 static guint32 hf_isi_sim_auth_indication_cfg = -1;
 
-void proto_reg_handoff_isi_sim_auth(void) {
-	static gboolean initialized=FALSE;
-
-	if (!initialized) {
-		isi_sim_auth_handle = create_dissector_handle(dissect_isi_sim_auth, proto_isi);
-		dissector_add("isi.resource", 0x08, isi_sim_auth_handle);
-	}
-}
-
 void proto_register_isi_sim_auth(void) {
 	static hf_register_info hf[] = {
 		{ &hf_isi_sim_auth_cmd,
-		  { "Command", "isi.sim.auth.cmd", FT_UINT8, BASE_HEX, isi_sim_auth_id, 0x0, "Command", HFILL }},
+		  { "Command", "isi.sim.auth.cmd", FT_UINT8, BASE_HEX|BASE_EXT_STRING, &isi_sim_auth_id_ext, 0x0, "Command", HFILL }},
 		{ &hf_isi_sim_auth_pw_type,
 		  { "Password Type", "isi.sim.auth.type", FT_UINT8, BASE_HEX, isi_sim_auth_pw_type, 0x0, "Password Type", HFILL }},
 		{ &hf_isi_sim_auth_pin,
@@ -127,152 +116,182 @@ void proto_register_isi_sim_auth(void) {
 	};
 
 	proto_register_field_array(proto_isi, hf, array_length(hf));
-	register_dissector("isi.sim.auth", dissect_isi_sim_auth, proto_isi);
 }
 
-static void dissect_isi_sim_auth(tvbuff_t *tvb, packet_info *pinfo, proto_item *isitree) {
-	proto_item *item = NULL;
-	proto_tree *tree = NULL;
-	guint8 cmd, code;
-
-	if(isitree) {
-		item = proto_tree_add_text(isitree, tvb, 0, -1, "Payload");
-		tree = proto_item_add_subtree(item, ett_isi_msg);
-
-		proto_tree_add_item(tree, hf_isi_sim_auth_cmd, tvb, 0, 1, FALSE);
-		cmd = tvb_get_guint8(tvb, 0);
-
-		switch(cmd) {
-			case 0x01: // SIM_AUTH_PROTECTED_REQ
-				proto_tree_add_item(tree, hf_isi_sim_auth_protection_req, tvb, 2, 1, FALSE);
-				cmd = tvb_get_guint8(tvb, 2);
-				switch(cmd) {
-					case 0x00: // DISABLE
-						proto_tree_add_item(tree, hf_isi_sim_auth_pin, tvb, 3, -1, FALSE);
-						col_set_str(pinfo->cinfo, COL_INFO, "disable SIM startup protection");
-						break;
-					case 0x01: // ENABLE
-						proto_tree_add_item(tree, hf_isi_sim_auth_pin, tvb, 3, -1, FALSE);
-						col_set_str(pinfo->cinfo, COL_INFO, "enable SIM startup protection");
-						break;
-					case 0x04: // STATUS
-						col_set_str(pinfo->cinfo, COL_INFO, "get SIM startup protection status");
-						break;
-					default:
-						col_set_str(pinfo->cinfo, COL_INFO, "unknown SIM startup protection packet");
-						break;
-				}
-				break;
-			case 0x02: // SIM_AUTH_PROTECTED_RESP
-				proto_tree_add_item(tree, hf_isi_sim_auth_protection_rsp, tvb, 1, 1, FALSE);
-				if(tvb_get_guint8(tvb, 1))
-					col_set_str(pinfo->cinfo, COL_INFO, "SIM startup protection enabled");
-				else
-					col_set_str(pinfo->cinfo, COL_INFO, "SIM startup protection disabled");
-				break;
-			case 0x04: // SIM_AUTH_UPDATE_REQ
-				proto_tree_add_item(tree, hf_isi_sim_auth_pw_type, tvb, 1, 1, FALSE);
-				code = tvb_get_guint8(tvb, 1);
-				switch(code) {
-					case 0x02: // PIN
-						col_set_str(pinfo->cinfo, COL_INFO, "update SIM PIN");
-						proto_tree_add_item(tree, hf_isi_sim_auth_pin, tvb, 2, 11, FALSE);
-						proto_tree_add_item(tree, hf_isi_sim_auth_new_pin, tvb, 13, 11, FALSE);
-						break;
-					case 0x03: // PUK
-						col_set_str(pinfo->cinfo, COL_INFO, "update SIM PUK");
-						break;
-					default:
-						col_set_str(pinfo->cinfo, COL_INFO, "unknown SIM Authentication update request");
-						break;
-				}
-				break;
-			case 0x05: // SIM_AUTH_UPDATE_SUCCESS_RESP
-				col_set_str(pinfo->cinfo, COL_INFO, "SIM Authentication update successful");
-				break;
-			case 0x06: // SIM_AUTH_UPDATE_FAIL_RESP
-				col_set_str(pinfo->cinfo, COL_INFO, "SIM Authentication update failed");
-				break;
-			case 0x07: // SIM_AUTH_REQ
-				proto_tree_add_item(tree, hf_isi_sim_auth_pw_type, tvb, 1, 1, FALSE);
-				code = tvb_get_guint8(tvb, 1);
-				switch(code) {
-					case 0x02: // PIN
-						col_set_str(pinfo->cinfo, COL_INFO, "SIM Authentication with PIN");
-						proto_tree_add_item(tree, hf_isi_sim_auth_pin, tvb, 2, 11, FALSE);
-						break;
-					case 0x03: // PUK
-						col_set_str(pinfo->cinfo, COL_INFO, "SIM Authentication with PUK");
-						proto_tree_add_item(tree, hf_isi_sim_auth_puk, tvb, 2, 11, FALSE);
-						proto_tree_add_item(tree, hf_isi_sim_auth_new_pin, tvb, 13, 11, FALSE);
-						break;
-					default:
-						col_set_str(pinfo->cinfo, COL_INFO, "unknown SIM Authentication request");
-						break;
-				}
-				break;
-			case 0x08: // SIM_AUTH_SUCCESS_RESP
-				col_set_str(pinfo->cinfo, COL_INFO, "SIM Authentication successful");
-				break;
-			case 0x09: // SIM_AUTH_FAIL_RESP
-				col_set_str(pinfo->cinfo, COL_INFO, "SIM Authentication failed");
-				break;
-			case 0x10: // SIM_AUTH_STATUS_IND
-				proto_tree_add_item(tree, hf_isi_sim_auth_indication, tvb, 1, 1, FALSE);
-				code = tvb_get_guint8(tvb, 1);
-				proto_tree_add_item(tree, hf_isi_sim_auth_pw_type, tvb, 2, 1, FALSE);
-				switch(code) {
-					case 0x01:
-						col_set_str(pinfo->cinfo, COL_INFO, "SIM Authentication indication: Authentication needed");
-						break;
-					case 0x02:
-						col_set_str(pinfo->cinfo, COL_INFO, "SIM Authentication indication: No Authentication needed");
-						break;
-					case 0x03:
-						col_set_str(pinfo->cinfo, COL_INFO, "SIM Authentication indication: Authentication valid");
-						break;
-					case 0x04:
-						col_set_str(pinfo->cinfo, COL_INFO, "SIM Authentication indication: Authentication invalid");
-						break;
-					case 0x05:
-						col_set_str(pinfo->cinfo, COL_INFO, "SIM Authentication indication: Authorized");
-						break;
-					case 0x06:
-						col_set_str(pinfo->cinfo, COL_INFO, "SIM Authentication indication: Config");
-						proto_tree_add_item(tree, hf_isi_sim_auth_indication_cfg, tvb, 3, 1, FALSE);
-						break;
-					default:
-						col_set_str(pinfo->cinfo, COL_INFO, "unknown SIM Authentication indication");
-						break;
-				}
-				break;
-			case 0x11: // SIM_AUTH_STATUS_REQ
-				col_set_str(pinfo->cinfo, COL_INFO, "SIM Authentication status request");
-				break;
-			case 0x12: // SIM_AUTH_STATUS_RESP
-				proto_tree_add_item(tree, hf_isi_sim_auth_status_rsp, tvb, 1, 1, FALSE);
-				code = tvb_get_guint8(tvb, 1);
-				switch(code) {
-					case 0x02:
-						col_set_str(pinfo->cinfo, COL_INFO, "SIM Authentication status: need PIN");
-						break;
-					case 0x03:
-						col_set_str(pinfo->cinfo, COL_INFO, "SIM Authentication status: need PUK");
-						break;
-					case 0x05:
-						col_set_str(pinfo->cinfo, COL_INFO, "SIM Authentication status: running");
-						break;
-					case 0x07:
-						col_set_str(pinfo->cinfo, COL_INFO, "SIM Authentication status: initializing");
-						break;
-					default:
-						col_set_str(pinfo->cinfo, COL_INFO, "unknown SIM Authentication status response packet");
-						break;
-				}
-				break;
-			default:
-				col_set_str(pinfo->cinfo, COL_INFO, "unknown SIM Authentication packet");
-				break;
-		}
+static void dissect_isi_sim_auth_protected_req(tvbuff_t *tvb, packet_info *pinfo, proto_item *item, proto_tree *tree) {
+	guint8 code;
+
+	proto_tree_add_item(tree, hf_isi_sim_auth_protection_req, tvb, 2, 1, FALSE);
+	code = tvb_get_guint8(tvb, 2);
+	switch(code) {
+		case 0x00: // DISABLE
+			proto_tree_add_item(tree, hf_isi_sim_auth_pin, tvb, 3, -1, FALSE);
+			col_set_str(pinfo->cinfo, COL_INFO, "disable SIM startup protection");
+			break;
+		case 0x01: // ENABLE
+			proto_tree_add_item(tree, hf_isi_sim_auth_pin, tvb, 3, -1, FALSE);
+			col_set_str(pinfo->cinfo, COL_INFO, "enable SIM startup protection");
+			break;
+		case 0x04: // STATUS
+			col_set_str(pinfo->cinfo, COL_INFO, "get SIM startup protection status");
+			break;
+		default:
+			col_set_str(pinfo->cinfo, COL_INFO, "unknown SIM startup protection packet");
+			break;
+	}
+}
+
+static void dissect_isi_sim_auth_protected_resp(tvbuff_t *tvb, packet_info *pinfo, proto_item *item, proto_tree *tree) {
+	proto_tree_add_item(tree, hf_isi_sim_auth_protection_rsp, tvb, 1, 1, FALSE);
+	if(tvb_get_guint8(tvb, 1))
+		col_set_str(pinfo->cinfo, COL_INFO, "SIM startup protection enabled");
+	else
+		col_set_str(pinfo->cinfo, COL_INFO, "SIM startup protection disabled");
+}
+
+static void dissect_isi_sim_auth_update_req(tvbuff_t *tvb, packet_info *pinfo, proto_item *item, proto_tree *tree) {
+	guint8 code;
+
+	proto_tree_add_item(tree, hf_isi_sim_auth_pw_type, tvb, 1, 1, FALSE);
+	code = tvb_get_guint8(tvb, 1);
+	switch(code) {
+		case 0x02: // PIN
+			col_set_str(pinfo->cinfo, COL_INFO, "update SIM PIN");
+			proto_tree_add_item(tree, hf_isi_sim_auth_pin, tvb, 2, 11, FALSE);
+			proto_tree_add_item(tree, hf_isi_sim_auth_new_pin, tvb, 13, 11, FALSE);
+			break;
+		case 0x03: // PUK
+			col_set_str(pinfo->cinfo, COL_INFO, "update SIM PUK");
+			break;
+		default:
+			col_set_str(pinfo->cinfo, COL_INFO, "unknown SIM Authentication update request");
+			break;
+	}
+}
+
+static void dissect_isi_sim_auth_update_success_resp(tvbuff_t *tvb, packet_info *pinfo, proto_item *item, proto_tree *tree) {
+	col_set_str(pinfo->cinfo, COL_INFO, "SIM Authentication update successful");
+}
+
+static void dissect_isi_sim_auth_update_fail_resp(tvbuff_t *tvb, packet_info *pinfo, proto_item *item, proto_tree *tree) {
+	col_set_str(pinfo->cinfo, COL_INFO, "SIM Authentication update failed");
+}
+
+static void dissect_isi_sim_auth_req(tvbuff_t *tvb, packet_info *pinfo, proto_item *item, proto_tree *tree) {
+	guint8 code;
+
+	proto_tree_add_item(tree, hf_isi_sim_auth_pw_type, tvb, 1, 1, FALSE);
+	code = tvb_get_guint8(tvb, 1);
+	switch(code) {
+		case 0x02: // PIN
+			col_set_str(pinfo->cinfo, COL_INFO, "SIM Authentication with PIN");
+			proto_tree_add_item(tree, hf_isi_sim_auth_pin, tvb, 2, 11, FALSE);
+			break;
+		case 0x03: // PUK
+			col_set_str(pinfo->cinfo, COL_INFO, "SIM Authentication with PUK");
+			proto_tree_add_item(tree, hf_isi_sim_auth_puk, tvb, 2, 11, FALSE);
+			proto_tree_add_item(tree, hf_isi_sim_auth_new_pin, tvb, 13, 11, FALSE);
+			break;
+		default:
+			col_set_str(pinfo->cinfo, COL_INFO, "unknown SIM Authentication request");
+			break;
+	}
+}
+
+static void dissect_isi_sim_auth_success_resp(tvbuff_t *tvb, packet_info *pinfo, proto_item *item, proto_tree *tree) {
+	col_set_str(pinfo->cinfo, COL_INFO, "SIM Authentication successful");
+}
+
+static void dissect_isi_sim_auth_fail_resp(tvbuff_t *tvb, packet_info *pinfo, proto_item *item, proto_tree *tree) {
+	col_set_str(pinfo->cinfo, COL_INFO, "SIM Authentication failed");
+}
+
+static void dissect_isi_sim_auth_status_ind(tvbuff_t *tvb, packet_info *pinfo, proto_item *item, proto_tree *tree) {
+	guint8 code;
+
+	proto_tree_add_item(tree, hf_isi_sim_auth_indication, tvb, 1, 1, FALSE);
+	code = tvb_get_guint8(tvb, 1);
+	proto_tree_add_item(tree, hf_isi_sim_auth_pw_type, tvb, 2, 1, FALSE);
+	switch(code) {
+		case 0x01:
+			col_set_str(pinfo->cinfo, COL_INFO, "SIM Authentication indication: Authentication needed");
+			break;
+		case 0x02:
+			col_set_str(pinfo->cinfo, COL_INFO, "SIM Authentication indication: No Authentication needed");
+			break;
+		case 0x03:
+			col_set_str(pinfo->cinfo, COL_INFO, "SIM Authentication indication: Authentication valid");
+			break;
+		case 0x04:
+			col_set_str(pinfo->cinfo, COL_INFO, "SIM Authentication indication: Authentication invalid");
+			break;
+		case 0x05:
+			col_set_str(pinfo->cinfo, COL_INFO, "SIM Authentication indication: Authorized");
+			break;
+		case 0x06:
+			col_set_str(pinfo->cinfo, COL_INFO, "SIM Authentication indication: Config");
+			proto_tree_add_item(tree, hf_isi_sim_auth_indication_cfg, tvb, 3, 1, FALSE);
+			break;
+		default:
+			col_set_str(pinfo->cinfo, COL_INFO, "unknown SIM Authentication indication");
+			break;
+	}
+}
+
+static void dissect_isi_sim_auth_status_req(tvbuff_t *tvb, packet_info *pinfo, proto_item *item, proto_tree *tree) {
+	col_set_str(pinfo->cinfo, COL_INFO, "SIM Authentication status request");
+}
+
+static void dissect_isi_sim_auth_status_resp(tvbuff_t *tvb, packet_info *pinfo, proto_item *item, proto_tree *tree) {
+	guint8 code;
+
+	proto_tree_add_item(tree, hf_isi_sim_auth_status_rsp, tvb, 1, 1, FALSE);
+	code = tvb_get_guint8(tvb, 1);
+	switch(code) {
+		case 0x02:
+			col_set_str(pinfo->cinfo, COL_INFO, "SIM Authentication status: need PIN");
+			break;
+		case 0x03:
+			col_set_str(pinfo->cinfo, COL_INFO, "SIM Authentication status: need PUK");
+			break;
+		case 0x05:
+			col_set_str(pinfo->cinfo, COL_INFO, "SIM Authentication status: running");
+			break;
+		case 0x07:
+			col_set_str(pinfo->cinfo, COL_INFO, "SIM Authentication status: initializing");
+			break;
+		default:
+			col_set_str(pinfo->cinfo, COL_INFO, "unknown SIM Authentication status response packet");
+			break;
+	}
+}
+
+static void dissect_isi_sim_auth_unknown(tvbuff_t *tvb, packet_info *pinfo, proto_item *item, proto_tree *tree) {
+	col_set_str(pinfo->cinfo, COL_INFO, "unknown SIM Authentication packet");
+}
+
+void proto_reg_handoff_isi_sim_auth(void) {
+	static gboolean initialized=FALSE;
+
+	if (!initialized) {
+		isi_register_resource(0x08, &hf_isi_sim_auth_cmd, dissect_isi_sim_auth_unknown);
+		isi_register_message(0x08, 0x01, dissect_isi_sim_auth_protected_req);
+		isi_register_message(0x08, 0x02, dissect_isi_sim_auth_protected_resp);
+		isi_register_message(0x08, 0x04, dissect_isi_sim_auth_update_req);
+		isi_register_message(0x08, 0x05, dissect_isi_sim_auth_update_success_resp);
+		isi_register_message(0x08, 0x06, dissect_isi_sim_auth_update_fail_resp);
+		isi_register_message(0x08, 0x07, dissect_isi_sim_auth_req);
+		isi_register_message(0x08, 0x08, dissect_isi_sim_auth_success_resp);
+		isi_register_message(0x08, 0x09, dissect_isi_sim_auth_fail_resp);
+		isi_register_message(0x08, 0x10, dissect_isi_sim_auth_status_ind);
+		isi_register_message(0x08, 0x11, dissect_isi_sim_auth_status_req);
+		isi_register_message(0x08, 0x12, dissect_isi_sim_auth_status_resp);
+
+		isi_register_transaction(0x08, 0x01, 0x02);
+		isi_register_transaction(0x08, 0x04, 0x05);
+		isi_register_transaction(0x08, 0x04, 0x06);
+		isi_register_transaction(0x08, 0x07, 0x08);
+		isi_register_transaction(0x08, 0x07, 0x09);
+		isi_register_transaction(0x08, 0x11, 0x12);
 	}
 }
@@ -23,6 +23,7 @@
 #include <glib.h>
 #include <epan/prefs.h>
 #include <epan/packet.h>
+#include <epan/tap.h>
 
 #include "packet-isi.h"
 #include "isi-sms.h"
@@ -48,14 +49,14 @@ static const value_string isi_sms_message_id[] = {
 	{0x0F, "SMS_GSM_TEMP_CB_ROUTING_RESP"},
 	{0x10, "SMS_GSM_TEMP_CB_ROUTING_NTF"},
 	{0x11, "SMS_GSM_CBCH_PRESENT_IND"},
-	{0x12, "SMS_PARAMETERS_UPDATE_REQ"},                
-	{0x13, "SMS_PARAMETERS_UPDATE_RESP"},               
-	{0x14, "SMS_PARAMETERS_READ_REQ"},                  
-	{0x15, "SMS_PARAMETERS_READ_RESP"},                 
-	{0x16, "SMS_PARAMETERS_CAPACITY_REQ"},              
-	{0x17, "SMS_PARAMETERS_CAPACITY_RESP"},             
-	{0x18, "SMS_GSM_SETTINGS_UPDATE_REQ"},              
-	{0x19, "SMS_GSM_SETTINGS_UPDATE_RESP"},   
+	{0x12, "SMS_PARAMETERS_UPDATE_REQ"},
+	{0x13, "SMS_PARAMETERS_UPDATE_RESP"},
+	{0x14, "SMS_PARAMETERS_READ_REQ"},
+	{0x15, "SMS_PARAMETERS_READ_RESP"},
+	{0x16, "SMS_PARAMETERS_CAPACITY_REQ"},
+	{0x17, "SMS_PARAMETERS_CAPACITY_RESP"},
+	{0x18, "SMS_GSM_SETTINGS_UPDATE_REQ"},
+	{0x19, "SMS_GSM_SETTINGS_UPDATE_RESP"},
 	{0x1A, "SMS_GSM_SETTINGS_READ_REQ"},
 	{0x1B, "SMS_GSM_SETTINGS_READ_RESP"},
 	{0x1C, "SMS_GSM_MCN_SETTING_CHANGED_IND"},
@@ -69,8 +70,9 @@ static const value_string isi_sms_message_id[] = {
 	{0x26, "SMS_SM_CONTROL_ACTIVATE_RESP"},
 	/* 0x29 is undocumented, but appears in traces */
 	{0xF0, "COMMON_MESSAGE"},
-	{0x00, NULL} 
+	{0x00, NULL}
 };
+static value_string_ext isi_sms_message_id_ext = VALUE_STRING_EXT_INIT(isi_sms_message_id);
 
 static const value_string isi_sms_routing_command[] = {
 	{0x00, "SMS_ROUTING_RELEASE"},
@@ -134,37 +136,20 @@ static const value_string isi_sms_send_status[] = {
 	{0x00, NULL},
 };
 
-static const value_string isi_sms_common_message_id[] = {
-	{0x01, "COMM_SERVICE_NOT_IDENTIFIED_RESP"},
-	{0x12, "COMM_ISI_VERSION_GET_REQ"},
-	{0x13, "COMM_ISI_VERSION_GET_RESP"},
-	{0x14, "COMM_ISA_ENTITY_NOT_REACHABLE_RESP"},
-};
-
-static dissector_handle_t isi_sms_handle;
-static void dissect_isi_sms(tvbuff_t *tvb, packet_info *pinfo, proto_item *tree);
-
 static guint32 hf_isi_sms_message_id = -1;
 static guint32 hf_isi_sms_routing_command = -1;
 static guint32 hf_isi_sms_routing_mode = -1;
 static guint32 hf_isi_sms_route = -1;
 static guint32 hf_isi_sms_subblock_count = -1;
 static guint32 hf_isi_sms_send_status = -1;
-static guint32 hf_isi_sms_common_message_id = -1;
+static guint32 hf_isi_sms_msg_ref = -1;
 
-void proto_reg_handoff_isi_sms(void) {
-	static gboolean initialized=FALSE;
-
-	if (!initialized) {
-		isi_sms_handle = create_dissector_handle(dissect_isi_sms, proto_isi);
-		dissector_add("isi.resource", 0x02, isi_sms_handle);
-	}
-}
+static int isi_sms_tap = -1;
 
 void proto_register_isi_sms(void) {
 	static hf_register_info hf[] = {
 		{ &hf_isi_sms_message_id,
-		  { "Message ID", "isi.sms.msg_id", FT_UINT8, BASE_HEX, isi_sms_message_id, 0x0, "Message ID", HFILL }},
+		  { "Message ID", "isi.sms.msg_id", FT_UINT8, BASE_HEX|BASE_EXT_STRING, &isi_sms_message_id_ext, 0x0, "Message ID", HFILL }},
 		{ &hf_isi_sms_routing_command,
 		  { "SMS Routing Command", "isi.sms.routing.command", FT_UINT8, BASE_HEX, isi_sms_routing_command, 0x0, "SMS Routing Command", HFILL }},
 		{ &hf_isi_sms_routing_mode,
@@ -175,154 +160,131 @@ void proto_register_isi_sms(void) {
 		  { "Subblock Count", "isi.sms.subblock_count", FT_UINT8, BASE_DEC, NULL, 0x0, "Subblock Count", HFILL }},
 		{ &hf_isi_sms_send_status,
 		  { "Sending Status", "isi.sms.sending_status", FT_UINT8, BASE_HEX, isi_sms_send_status, 0x0, "Sending Status", HFILL }},    
+		{ &hf_isi_sms_msg_ref,
+		  { "Message Reference", "isi.sms.msg_ref", FT_UINT8, BASE_DEC, NULL, 0x0, "Message Reference", HFILL }},
 //		{ &hf_isi_sms_subblock,
 //		  { "Subblock", "isi.sms.subblock", FT_UINT8, BASE_HEX, isi_sms_subblock, 0x0, "Subblock", HFILL }},
-		{ &hf_isi_sms_common_message_id,
-		  { "Common Message ID", "isi.sms.common.msg_id", FT_UINT8, BASE_HEX, isi_sms_common_message_id, 0x0, "Common Message ID", HFILL }},
 	};
 
 	proto_register_field_array(proto_isi, hf, array_length(hf));
-	register_dissector("isi.sms", dissect_isi_sms, proto_isi);
+	isi_sms_tap = register_tap("isi.sms");
+}
+
+static void isi_sms_tap_queue(tvbuff_t *tvb, packet_info *pinfo, guint8 status, guint8 msg_ref) {
+	isi_sms_tap_info_t *info;
+
+	if(!have_tap_listener(isi_sms_tap))
+		return;
+
+	info = ep_alloc0(sizeof(isi_sms_tap_info_t));
+	info->msg_id = tvb_get_guint8(tvb, 0);
+	info->status = status;
+	info->msg_ref = msg_ref;
+	isi_get_response(pinfo, tvb, &info->request_in, &info->response_time);
+
+	tap_queue_packet(isi_sms_tap, pinfo, info);
+}
+
+static void dissect_isi_sms_message_send_req(tvbuff_t *tvb, packet_info *pinfo, proto_item *item, proto_tree *tree) {
+	col_set_str(pinfo->cinfo, COL_INFO, "SMS Message Send Request");
+	isi_sms_tap_queue(tvb, pinfo, 0, 0);
 }
 
-static void dissect_isi_sms(tvbuff_t *tvb, packet_info *pinfo, proto_item *isitree) {
-	proto_item *item = NULL;
-	proto_tree *tree = NULL;
-	guint8 cmd, code;
+static void dissect_isi_sms_message_send_resp(tvbuff_t *tvb, packet_info *pinfo, proto_item *item, proto_tree *tree) {
+	proto_tree_add_item(tree, hf_isi_sms_subblock_count, tvb, 2, 1, FALSE);
+	col_set_str(pinfo->cinfo, COL_INFO, "SMS Message Send Response");
+	isi_sms_tap_queue(tvb, pinfo, 0, 0);
+}
 
-	if(isitree) {
-		item = proto_tree_add_text(isitree, tvb, 0, -1, "Payload");
-		tree = proto_item_add_subtree(item, ett_isi_msg);
+static void dissect_isi_sms_pp_routing_req(tvbuff_t *tvb, packet_info *pinfo, proto_item *item, proto_tree *tree) {
+	proto_tree_add_item(tree, hf_isi_sms_routing_command, tvb, 1, 1, FALSE);
+	proto_tree_add_item(tree, hf_isi_sms_subblock_count, tvb, 2, 1, FALSE);
+	col_set_str(pinfo->cinfo, COL_INFO, "SMS Point-to-Point Routing Request");
+}
 
-		proto_tree_add_item(tree, hf_isi_sms_message_id, tvb, 0, 1, FALSE);
-		cmd = tvb_get_guint8(tvb, 0);
+static void dissect_isi_sms_pp_routing_resp(tvbuff_t *tvb, packet_info *pinfo, proto_item *item, proto_tree *tree) {
+	col_set_str(pinfo->cinfo, COL_INFO, "SMS Point-to-Point Routing Response");
+}
 
-		switch(cmd) {
-			case 0x03: /* SMS_MESSAGE_SEND_RESP */
-				proto_tree_add_item(tree, hf_isi_sms_subblock_count, tvb, 2, 1, FALSE);
-				code = tvb_get_guint8(tvb, 1);
-				switch(code) {
-//					case 0x05:
-//						col_set_str(pinfo->cinfo, COL_INFO, "Service Request: Interrogation");
-//						break;
-//				case 0x06:
-//						col_set_str(pinfo->cinfo, COL_INFO, "Service Request: GSM Password Registration");
-//						break;
-					default:
-						col_set_str(pinfo->cinfo, COL_INFO, "SMS Message Send Response");
-						break;
-				}
-				break; 
-				
-			case 0x06: /* SMS_PP_ROUTING_REQ */
-				proto_tree_add_item(tree, hf_isi_sms_routing_command, tvb, 1, 1, FALSE);
-				proto_tree_add_item(tree, hf_isi_sms_subblock_count, tvb, 2, 1, FALSE);
-				code = tvb_get_guint8(tvb, 1);
-				switch(code) {
-//					case 0x05:
-//						col_set_str(pinfo->cinfo, COL_INFO, "Service Request: Interrogation");
-//						break;
-//				case 0x06:
-//						col_set_str(pinfo->cinfo, COL_INFO, "Service Request: GSM Password Registration");
-//						break;
-					default:
-						col_set_str(pinfo->cinfo, COL_INFO, "SMS Point-to-Point Routing Request");
-						break;
-				}
-				break; 
-				
-			case 0x07: /* SMS_PP_ROUTING_RESP */
-//				//proto_tree_add_item(tree, hf_isi_sms_service_type, tvb, 1, 1, FALSE);
-				code = tvb_get_guint8(tvb, 1);
-				switch(code) {
-//					//case 0x2F:
-//					//	col_set_str(pinfo->cinfo, COL_INFO, "Network Information Request: Read Home PLMN");
-//					//	break;
-					default:
-						col_set_str(pinfo->cinfo, COL_INFO, "SMS Point-to-Point Routing Response");
-						break;
-				}
-				break; 
-				
-			case 0x0B: /* SMS_GSM_CB_ROUTING_REQ */
-				proto_tree_add_item(tree, hf_isi_sms_routing_command, tvb, 1, 1, FALSE);
-				proto_tree_add_item(tree, hf_isi_sms_routing_mode, tvb, 2, 1, FALSE);
-//				proto_tree_add_item(tree, hf_isi_sms_cb_subject_list_type, tvb, 3, 1, FALSE);
-//				proto_tree_add_item(tree, hf_isi_sms_cb_subject_count, tvb, 4, 1, FALSE);
-//				proto_tree_add_item(tree, hf_isi_sms_cb_language_count, tvb, 5, 1, FALSE);
-//				proto_tree_add_item(tree, hf_isi_sms_cb_range, tvb, 6, 1, FALSE);
-				code = tvb_get_guint8(tvb, 1);
-				switch(code) {
-					case 0x00:
-						col_set_str(pinfo->cinfo, COL_INFO, "SMS GSM Cell Broadcast Routing Release");
-						break;
-					case 0x01:
-						col_set_str(pinfo->cinfo, COL_INFO, "SMS GSM Cell Broadcast Routing Set");
-						break;
-					default:
-						col_set_str(pinfo->cinfo, COL_INFO, "SMS GSM Cell Broadcast Routing Request");
-						break;
-				}
-				break; 
-								
-			case 0x0C: /* SMS_GSM_CB_ROUTING_RESP */
-//				proto_tree_add_item(tree, hf_isi_sms_operation, tvb, 1, 1, FALSE);
-//				proto_tree_add_item(tree, hf_isi_sms_service_code, tvb, 2, 1, FALSE);
-				code = tvb_get_guint8(tvb, 1);
-				switch(code) {
-//					case 0x05:
-//						col_set_str(pinfo->cinfo, COL_INFO, "Service Completed Response: Interrogation");
-//						break;
-					default:
-						col_set_str(pinfo->cinfo, COL_INFO, "SMS GSM Cell Broadcast Routing Response");
-						break;
-				}
-				break; 
+static void dissect_isi_sms_gsm_cb_routing_req(tvbuff_t *tvb, packet_info *pinfo, proto_item *item, proto_tree *tree) {
+	guint8 code;
 
-			case 0x22: /* SMS_MESSAGE_SEND_STATUS_IND */
-				proto_tree_add_item(tree, hf_isi_sms_send_status, tvb, 1, 1, FALSE);
-				/* The second byte is a "segment" identifier/"Message Reference" */
-				proto_tree_add_item(tree, hf_isi_sms_route, tvb, 3, 1, FALSE);
-				code = tvb_get_guint8(tvb, 1);
-				switch(code) {
-					case 0x02:
-						col_set_str(pinfo->cinfo, COL_INFO, "SMS Message Sending Status: Waiting for Network");
-						break;
-					case 0x03:
-						col_set_str(pinfo->cinfo, COL_INFO, "SMS Message Sending Status: Idle");
-						break;
-					default:
-						col_set_str(pinfo->cinfo, COL_INFO, "SMS Message Sending Status Indication");
-						break;
-				}
-				break; 	
+	proto_tree_add_item(tree, hf_isi_sms_routing_command, tvb, 1, 1, FALSE);
+	proto_tree_add_item(tree, hf_isi_sms_routing_mode, tvb, 2, 1, FALSE);
+//	proto_tree_add_item(tree, hf_isi_sms_cb_subject_list_type, tvb, 3, 1, FALSE);
+//	proto_tree_add_item(tree, hf_isi_sms_cb_subject_count, tvb, 4, 1, FALSE);
+//	proto_tree_add_item(tree, hf_isi_sms_cb_language_count, tvb, 5, 1, FALSE);
+//	proto_tree_add_item(tree, hf_isi_sms_cb_range, tvb, 6, 1, FALSE);
+	code = tvb_get_guint8(tvb, 1);
+	switch(code) {
+		case 0x00:
+			col_set_str(pinfo->cinfo, COL_INFO, "SMS GSM Cell Broadcast Routing Release");
+			break;
+		case 0x01:
+			col_set_str(pinfo->cinfo, COL_INFO, "SMS GSM Cell Broadcast Routing Set");
+			break;
+		default:
+			col_set_str(pinfo->cinfo, COL_INFO, "SMS GSM Cell Broadcast Routing Request");
+			break;
+	}
+}
 
-			case 0xF0: /* SS_COMMON_MESSAGE */
-				proto_tree_add_item(tree, hf_isi_sms_common_message_id, tvb, 1, 1, FALSE);
-				code = tvb_get_guint8(tvb, 1);
-				switch(code) {
-					case 0x01: /* COMM_SERVICE_NOT_IDENTIFIED_RESP */
-						col_set_str(pinfo->cinfo, COL_INFO, "Common Message: Service Not Identified Response");
-						break;
-					case 0x12: /* COMM_ISI_VERSION_GET_REQ */
-						col_set_str(pinfo->cinfo, COL_INFO, "Common Message: ISI Version Get Request");
-						break;
-					case 0x13: /* COMM_ISI_VERSION_GET_RESP */
-						col_set_str(pinfo->cinfo, COL_INFO, "Common Message: ISI Version Get Response");
-						break;
-					case 0x14: /* COMM_ISA_ENTITY_NOT_REACHABLE_RESP */
-						col_set_str(pinfo->cinfo, COL_INFO, "Common Message: ISA Entity Not Reachable");
-						break;
-					default:
-						col_set_str(pinfo->cinfo, COL_INFO, "Common Message");
-						break;
-				}
-				break; 
+static void dissect_isi_sms_gsm_cb_routing_resp(tvbuff_t *tvb, packet_info *pinfo, proto_item *item, proto_tree *tree) {
+	col_set_str(pinfo->cinfo, COL_INFO, "SMS GSM Cell Broadcast Routing Response");
+}
+
+static void dissect_isi_sms_message_send_status_ind(tvbuff_t *tvb, packet_info *pinfo, proto_item *item, proto_tree *tree) {
+	guint8 code;
+
+	proto_tree_add_item(tree, hf_isi_sms_send_status, tvb, 1, 1, FALSE);
+	/* The second byte is a "segment" identifier/"Message Reference" */
+	proto_tree_add_item(tree, hf_isi_sms_msg_ref, tvb, 2, 1, FALSE);
+	proto_tree_add_item(tree, hf_isi_sms_route, tvb, 3, 1, FALSE);
+	code = tvb_get_guint8(tvb, 1);
+	isi_sms_tap_queue(tvb, pinfo, code, tvb_get_guint8(tvb, 2));
+	switch(code) {
+		case 0x02:
+			col_set_str(pinfo->cinfo, COL_INFO, "SMS Message Sending Status: Waiting for Network");
+			break;
+		case 0x03:
+			col_set_str(pinfo->cinfo, COL_INFO, "SMS Message Sending Status: Idle");
+			break;
+		default:
+			col_set_str(pinfo->cinfo, COL_INFO, "SMS Message Sending Status Indication");
+			break;
+	}
+}
+
+static void dissect_isi_sms_unknown(tvbuff_t *tvb, packet_info *pinfo, proto_item *item, proto_tree *tree) {
+	col_set_str(pinfo->cinfo, COL_INFO, "Unknown type");
+}
+
+void proto_reg_handoff_isi_sms(void) {
+	static gboolean initialized=FALSE;
+
+	if (!initialized) {
+		isi_register_resource(0x02, &hf_isi_sms_message_id, dissect_isi_sms_unknown);
+		isi_register_message(0x02, 0x02, dissect_isi_sms_message_send_req);
+		isi_register_message(0x02, 0x03, dissect_isi_sms_message_send_resp);
+		isi_register_message(0x02, 0x06, dissect_isi_sms_pp_routing_req);
+		isi_register_message(0x02, 0x07, dissect_isi_sms_pp_routing_resp);
+		isi_register_message(0x02, 0x0B, dissect_isi_sms_gsm_cb_routing_req);
+		isi_register_message(0x02, 0x0C, dissect_isi_sms_gsm_cb_routing_resp);
+		isi_register_message(0x02, 0x22, dissect_isi_sms_message_send_status_ind);
 
-				
-			default:
-				col_set_str(pinfo->cinfo, COL_INFO, "Unknown type");
-				break;
-		}
+		isi_register_transaction(0x02, 0x00, 0x01);
+		isi_register_transaction(0x02, 0x02, 0x03);
+		isi_register_transaction(0x02, 0x06, 0x07);
+		isi_register_transaction(0x02, 0x09, 0x0A);
+		isi_register_transaction(0x02, 0x0B, 0x0C);
+		isi_register_transaction(0x02, 0x0E, 0x0F);
+		isi_register_transaction(0x02, 0x12, 0x13);
+		isi_register_transaction(0x02, 0x14, 0x15);
+		isi_register_transaction(0x02, 0x16, 0x17);
+		isi_register_transaction(0x02, 0x18, 0x19);
+		isi_register_transaction(0x02, 0x1A, 0x1B);
+		isi_register_transaction(0x02, 0x1E, 0x1F);
+		isi_register_transaction(0x02, 0x23, 0x24);
+		isi_register_transaction(0x02, 0x25, 0x26);
 	}
 }
@@ -4,4 +4,20 @@
 void proto_reg_handoff_isi_sms(void);
 void proto_register_isi_sms(void);
 
+/* SMS_MESSAGE_SEND_STATUS_IND states */
+#define ISI_SMS_MSG_REROUTED		0x00
+#define ISI_SMS_MSG_REPEATED		0x01
+#define ISI_SMS_MSG_WAITING_NETWORK	0x02
+#define ISI_SMS_MSG_IDLE		0x03
+
+/* Data of the "isi.sms" tap, queued for SMS_MESSAGE_SEND_REQ,
+ * SMS_MESSAGE_SEND_RESP and SMS_MESSAGE_SEND_STATUS_IND */
+typedef struct _isi_sms_tap_info_t {
+	guint8 msg_id;
+	guint8 status;		/* status indication only */
+	guint8 msg_ref;		/* status indication only */
+	guint32 request_in;	/* response only, 0 if unmatched */
+	nstime_t response_time;
+} isi_sms_tap_info_t;
+
 #endif
@@ -44,7 +44,9 @@ static const value_string isi_ss_message_id[] = {
 	{0x15, "SS_RELEASE_REQ"},
 	{0x16, "SS_RELEASE_RESP"},
 	{0xF0, "COMMON_MESSAGE"},
+	{0x00, NULL}
 };
+static value_string_ext isi_ss_message_id_ext = VALUE_STRING_EXT_INIT(isi_ss_message_id);
 
 static const value_string isi_ss_ussd_type[] = {
 	{0x01, "SS_GSM_USSD_MT_REPLY"},
@@ -52,6 +54,7 @@ static const value_string isi_ss_ussd_type[] = {
 	{0x03, "SS_GSM_USSD_REQUEST"},
 	{0x04, "SS_GSM_USSD_NOTIFY"},
 	{0x05, "SS_GSM_USSD_END"},
+	{0x00, NULL}
 };
 
 static const value_string isi_ss_subblock[] = {
@@ -67,6 +70,7 @@ static const value_string isi_ss_subblock[] = {
 	{0x0E, "SS_GSM_INDICATE_ERROR"},
 	{0x2F, "SS_GSM_ADDITIONAL_INFO"},
 	{0x32, "SS_GSM_USSD_STRING"},
+	{0x00, NULL}
 };
 
 static const value_string isi_ss_operation[] = {
@@ -76,6 +80,7 @@ static const value_string isi_ss_operation[] = {
 	{0x04, "SS_ERASURE"},
 	{0x05, "SS_INTERROGATION"},
 	{0x06, "SS_GSM_PASSWORD_REGISTRATION"},
+	{0x00, NULL}
 };
 
 static const value_string isi_ss_service_code[] = {
@@ -96,16 +101,6 @@ static const value_string isi_ss_status_indication[] = {
 	{0x00, NULL}
 };
 
-static const value_string isi_ss_common_message_id[] = {
-	{0x01, "COMM_SERVICE_NOT_IDENTIFIED_RESP"},
-	{0x12, "COMM_ISI_VERSION_GET_REQ"},
-	{0x13, "COMM_ISI_VERSION_GET_RESP"},
-	{0x14, "COMM_ISA_ENTITY_NOT_REACHABLE_RESP"},
-};
-
-static dissector_handle_t isi_ss_handle;
-static void dissect_isi_ss(tvbuff_t *tvb, packet_info *pinfo, proto_item *tree);
-
 static guint32 hf_isi_ss_message_id = -1;
 static guint32 hf_isi_ss_ussd_type = -1;
 static guint32 hf_isi_ss_subblock_count = -1;
@@ -114,23 +109,12 @@ static guint32 hf_isi_ss_operation = -1;
 static guint32 hf_isi_ss_service_code = -1;
 static guint32 hf_isi_ss_status_indication = -1;
 static guint32 hf_isi_ss_ussd_length = -1;
-static guint8 hf_isi_ss_ussd_content = -1;
-
-static guint32 hf_isi_ss_common_message_id = -1;
-
-void proto_reg_handoff_isi_ss(void) {
-	static gboolean initialized=FALSE;
-
-	if (!initialized) {
-		isi_ss_handle = create_dissector_handle(dissect_isi_ss, proto_isi);
-		dissector_add("isi.resource", 0x06, isi_ss_handle);
-	}
-}
+static guint32 hf_isi_ss_ussd_content = -1;
 
 void proto_register_isi_ss(void) {
 	static hf_register_info hf[] = {
 		{ &hf_isi_ss_message_id,
-		  { "Message ID", "isi.ss.msg_id", FT_UINT8, BASE_HEX, isi_ss_message_id, 0x0, "Message ID", HFILL }},
+		  { "Message ID", "isi.ss.msg_id", FT_UINT8, BASE_HEX|BASE_EXT_STRING, &isi_ss_message_id_ext, 0x0, "Message ID", HFILL }},
 		{ &hf_isi_ss_ussd_type,
 		  { "USSD Type", "isi.ss.ussd.type", FT_UINT8, BASE_HEX, isi_ss_ussd_type, 0x0, "USSD Type", HFILL }},
 		{ &hf_isi_ss_subblock_count,
@@ -145,183 +129,175 @@ void proto_register_isi_ss(void) {
 		  { "Status Indication", "isi.ss.status_indication", FT_UINT8, BASE_HEX, isi_ss_status_indication, 0x0, "Status Indication", HFILL }},
 		{ &hf_isi_ss_ussd_length,
 		  { "Length", "isi.ss.ussd.length", FT_UINT8, BASE_DEC, NULL, 0x0, "Length", HFILL }},
-		{ &hf_isi_ss_common_message_id,
-		  { "Common Message ID", "isi.ss.common.msg_id", FT_UINT8, BASE_HEX, isi_ss_common_message_id, 0x0, "Common Message ID", HFILL }},
+		{ &hf_isi_ss_ussd_content,
+		  { "USSD String", "isi.ss.ussd.content", FT_STRING, BASE_NONE, NULL, 0x0, "USSD String", HFILL }},
 	};
 
 	proto_register_field_array(proto_isi, hf, array_length(hf));
-	register_dissector("isi.ss", dissect_isi_ss, proto_isi);
 }
 
-static void dissect_isi_ss(tvbuff_t *tvb, packet_info *pinfo, proto_item *isitree) {
-	proto_item *item = NULL;
-	proto_tree *tree = NULL;
-	guint8 cmd, code;
-
-	if(isitree) {
-		item = proto_tree_add_text(isitree, tvb, 0, -1, "Payload");
-		tree = proto_item_add_subtree(item, ett_isi_msg);
-
-		proto_tree_add_item(tree, hf_isi_ss_message_id, tvb, 0, 1, FALSE);
-		cmd = tvb_get_guint8(tvb, 0);
-
-		switch(cmd) {
-			case 0x00: /* SS_SERVICE_REQ */
-				proto_tree_add_item(tree, hf_isi_ss_operation, tvb, 1, 1, FALSE);
-				proto_tree_add_item(tree, hf_isi_ss_service_code, tvb, 2, 1, FALSE);
-				code = tvb_get_guint8(tvb, 1);
-				switch(code) {
-					case 0x05:
-						col_set_str(pinfo->cinfo, COL_INFO, "Service Request: Interrogation");
-						break;
-					case 0x06:
-						col_set_str(pinfo->cinfo, COL_INFO, "Service Request: GSM Password Registration");
-						break;
-					default:
-						col_set_str(pinfo->cinfo, COL_INFO, "Service Request");
-						break;
-				}
-				break;
-
-			case 0x01: /* SS_SERVICE_COMPLETED_RESP */
-				proto_tree_add_item(tree, hf_isi_ss_operation, tvb, 1, 1, FALSE);
-				proto_tree_add_item(tree, hf_isi_ss_service_code, tvb, 2, 1, FALSE);
-				code = tvb_get_guint8(tvb, 1);
-				switch(code) {
-					case 0x05:
-						col_set_str(pinfo->cinfo, COL_INFO, "Service Completed Response: Interrogation");
-						break;
-					default:
-						col_set_str(pinfo->cinfo, COL_INFO, "Service Completed Response");
-						break;
-				}
-				break;
-
-			case 0x02: /* SS_SERVICE_FAILED_RESP */
-				//proto_tree_add_item(tree, hf_isi_ss_service_type, tvb, 1, 1, FALSE);
-				code = tvb_get_guint8(tvb, 1);
-				switch(code) {
-					//case 0x2F:
-					//	col_set_str(pinfo->cinfo, COL_INFO, "Network Information Request: Read Home PLMN");
-					//	break;
-					default:
-						col_set_str(pinfo->cinfo, COL_INFO, "Service Failed Response");
-						break;
-				}
-				break;
-
-			case 0x04: /* SS_GSM_USSD_SEND_REQ */
-				proto_tree_add_item(tree, hf_isi_ss_ussd_type, tvb, 1, 1, FALSE);
-				proto_tree_add_item(tree, hf_isi_ss_subblock_count, tvb, 2, 1, FALSE);
-
-				code = tvb_get_guint8(tvb, 1);
-				switch(code) {
-					case 0x02: //SS_GSM_USSD_COMMAND
-						proto_tree_add_item(tree, hf_isi_ss_subblock, tvb, 3, 1, FALSE);
-						col_set_str(pinfo->cinfo, COL_INFO, "GSM USSD Send Command Request");
-						break;
-					default:
-						col_set_str(pinfo->cinfo, COL_INFO, "GSM USSD Message Send Request");
-						break;
-				}
-				break;
-
-			case 0x05: /* SS_GSM_USSD_SEND_RESP */
-				//proto_tree_add_item(tree, hf_isi_ss_service_type, tvb, 1, 1, FALSE);
-				code = tvb_get_guint8(tvb, 1);
-				switch(code) {
-					//case 0x2F:
-					//	col_set_str(pinfo->cinfo, COL_INFO, "Network Information Request: Read Home PLMN");
-					//	break;
-					default:
-						col_set_str(pinfo->cinfo, COL_INFO, "GSM USSD Message Send Response");
-						break;
-				}
-				break;
-
-			case 0x06: /* SS_GSM_USSD_RECEIVE_IND */
-			  //An unknown Encoding Information byte precedes - see 3GPP TS 23.038 chapter 5
-				proto_tree_add_item(tree, hf_isi_ss_ussd_type, tvb, 2, 1, FALSE);
-				proto_tree_add_item(tree, hf_isi_ss_ussd_length, tvb, 3, 1, FALSE);
-
-				code = tvb_get_guint8(tvb, 1);
-				switch(code) {
-					case 0x04:
-
-
-
-						col_set_str(pinfo->cinfo, COL_INFO, "GSM USSD Message Received Notification");
-						break;
-					default:
-						col_set_str(pinfo->cinfo, COL_INFO, "GSM USSD Message Received Indication");
-						break;
-				}
-				break;
-
-			case 0x09: /* SS_STATUS_IND */
-				proto_tree_add_item(tree, hf_isi_ss_status_indication, tvb, 1, 1, FALSE);
-				proto_tree_add_item(tree, hf_isi_ss_subblock_count, tvb, 2, 1, FALSE);
-				//proto_tree_add_item(tree, hf_isi_ss_subblock, tvb, 3, 1, FALSE);
-				code = tvb_get_guint8(tvb, 1);
-				switch(code) {
-					case 0x00:
-						col_set_str(pinfo->cinfo, COL_INFO, "Status Indication: Request Service Start");
-						break;
-					case 0x01:
-						col_set_str(pinfo->cinfo, COL_INFO, "Status Indication: Request Service Stop");
-						break;
-					case 0x02:
-						col_set_str(pinfo->cinfo, COL_INFO, "Status Indication: Request USSD Start");
-						break;
-					case 0x03:
-						col_set_str(pinfo->cinfo, COL_INFO, "Status Indication: Request USSD Stop");
-						break;
-					default:
-						col_set_str(pinfo->cinfo, COL_INFO, "Status Indication");
-						break;
-				}
-				break;
-
-			case 0x10: /* SS_SERVICE_COMPLETED_IND */
-				proto_tree_add_item(tree, hf_isi_ss_operation, tvb, 1, 1, FALSE);
-				proto_tree_add_item(tree, hf_isi_ss_service_code, tvb, 2, 1, FALSE);
-				code = tvb_get_guint8(tvb, 1);
-				switch(code) {
-					case 0x05:
-						col_set_str(pinfo->cinfo, COL_INFO, "Service Completed Indication: Interrogation");
-						break;
-					default:
-						col_set_str(pinfo->cinfo, COL_INFO, "Service Completed Indication");
-						break;
-				}
-				break;
-
-			case 0xF0: /* SS_COMMON_MESSAGE */
-				proto_tree_add_item(tree, hf_isi_ss_common_message_id, tvb, 1, 1, FALSE);
-				code = tvb_get_guint8(tvb, 1);
-				switch(code) {
-					case 0x01: /* COMM_SERVICE_NOT_IDENTIFIED_RESP */
-						col_set_str(pinfo->cinfo, COL_INFO, "Common Message: Service Not Identified Response");
-						break;
-					case 0x12: /* COMM_ISI_VERSION_GET_REQ */
-						col_set_str(pinfo->cinfo, COL_INFO, "Common Message: ISI Version Get Request");
-						break;
-					case 0x13: /* COMM_ISI_VERSION_GET_RESP */
-						col_set_str(pinfo->cinfo, COL_INFO, "Common Message: ISI Version Get Response");
-						break;
-					case 0x14: /* COMM_ISA_ENTITY_NOT_REACHABLE_RESP */
-						col_set_str(pinfo->cinfo, COL_INFO, "Common Message: ISA Entity Not Reachable");
-						break;
-					default:
-						col_set_str(pinfo->cinfo, COL_INFO, "Common Message");
-						break;
-				}
-				break;
-
-
-			default:
-				col_set_str(pinfo->cinfo, COL_INFO, "Unknown type");
-				break;
-		}
+static void dissect_isi_ss_service_req(tvbuff_t *tvb, packet_info *pinfo, proto_item *item, proto_tree *tree) {
+	guint8 code;
+
+	proto_tree_add_item(tree, hf_isi_ss_operation, tvb, 1, 1, FALSE);
+	proto_tree_add_item(tree, hf_isi_ss_service_code, tvb, 2, 1, FALSE);
+	code = tvb_get_guint8(tvb, 1);
+	switch(code) {
+		case 0x05:
+			col_set_str(pinfo->cinfo, COL_INFO, "Service Request: Interrogation");
+			break;
+		case 0x06:
+			col_set_str(pinfo->cinfo, COL_INFO, "Service Request: GSM Password Registration");
+			break;
+		default:
+			col_set_str(pinfo->cinfo, COL_INFO, "Service Request");
+			break;
+	}
+}
+
+static void dissect_isi_ss_service_completed_resp(tvbuff_t *tvb, packet_info *pinfo, proto_item *item, proto_tree *tree) {
+	guint8 code;
+
+	proto_tree_add_item(tree, hf_isi_ss_operation, tvb, 1, 1, FALSE);
+	proto_tree_add_item(tree, hf_isi_ss_service_code, tvb, 2, 1, FALSE);
+	code = tvb_get_guint8(tvb, 1);
+	switch(code) {
+		case 0x05:
+			col_set_str(pinfo->cinfo, COL_INFO, "Service Completed Response: Interrogation");
+			break;
+		default:
+			col_set_str(pinfo->cinfo, COL_INFO, "Service Completed Response");
+			break;
+	}
+}
+
+static void dissect_isi_ss_service_failed_resp(tvbuff_t *tvb, packet_info *pinfo, proto_item *item, proto_tree *tree) {
+	//proto_tree_add_item(tree, hf_isi_ss_service_type, tvb, 1, 1, FALSE);
+	col_set_str(pinfo->cinfo, COL_INFO, "Service Failed Response");
+}
+
+static void dissect_isi_ss_gsm_ussd_send_req(tvbuff_t *tvb, packet_info *pinfo, proto_item *item, proto_tree *tree) {
+	guint8 code;
+
+	proto_tree_add_item(tree, hf_isi_ss_ussd_type, tvb, 1, 1, FALSE);
+	proto_tree_add_item(tree, hf_isi_ss_subblock_count, tvb, 2, 1, FALSE);
+
+	code = tvb_get_guint8(tvb, 1);
+	switch(code) {
+		case 0x02: //SS_GSM_USSD_COMMAND
+			proto_tree_add_item(tree, hf_isi_ss_subblock, tvb, 3, 1, FALSE);
+			col_set_str(pinfo->cinfo, COL_INFO, "GSM USSD Send Command Request");
+			break;
+		default:
+			col_set_str(pinfo->cinfo, COL_INFO, "GSM USSD Message Send Request");
+			break;
+	}
+}
+
+static void dissect_isi_ss_gsm_ussd_send_resp(tvbuff_t *tvb, packet_info *pinfo, proto_item *item, proto_tree *tree) {
+	col_set_str(pinfo->cinfo, COL_INFO, "GSM USSD Message Send Response");
+}
+
+/* UCS-2 coded cell broadcast data coding schemes, see 3GPP TS 23.038 chapter 5 */
+static gboolean isi_ss_dcs_is_ucs2(guint8 dcs) {
+	if(dcs == 0x11)
+		return TRUE;
+	if((dcs & 0xC0) == 0x40 || (dcs & 0xF0) == 0x90)
+		return (dcs & 0x0C) == 0x08;
+	return FALSE;
+}
+
+static void dissect_isi_ss_gsm_ussd_receive_ind(tvbuff_t *tvb, packet_info *pinfo, proto_item *item, proto_tree *tree) {
+	guint8 code, dcs, len;
+
+	//An unknown Encoding Information byte precedes - see 3GPP TS 23.038 chapter 5
+	proto_tree_add_item(tree, hf_isi_ss_ussd_type, tvb, 2, 1, FALSE);
+	proto_tree_add_item(tree, hf_isi_ss_ussd_length, tvb, 3, 1, FALSE);
+
+	/* only UCS-2 strings are decoded, GSM 7 bit packed text is not yet */
+	dcs = tvb_get_guint8(tvb, 2);
+	len = tvb_get_guint8(tvb, 3);
+	if(tree && isi_ss_dcs_is_ucs2(dcs) && tvb_bytes_exist(tvb, 4, len)) {
+		/* 0x11 is preceded by a two byte language indication */
+		if(dcs == 0x11 && len >= 2)
+			proto_tree_add_string(tree, hf_isi_ss_ussd_content, tvb, 6, len-2, isi_ucs2_to_utf8(tvb, 6, (len-2)/2));
+		else
+			proto_tree_add_string(tree, hf_isi_ss_ussd_content, tvb, 4, len, isi_ucs2_to_utf8(tvb, 4, len/2));
+	}
+
+	code = tvb_get_guint8(tvb, 1);
+	switch(code) {
+		case 0x04:
+			col_set_str(pinfo->cinfo, COL_INFO, "GSM USSD Message Received Notification");
+			break;
+		default:
+			col_set_str(pinfo->cinfo, COL_INFO, "GSM USSD Message Received Indication");
+			break;
+	}
+}
+
+static void dissect_isi_ss_status_ind(tvbuff_t *tvb, packet_info *pinfo, proto_item *item, proto_tree *tree) {
+	guint8 code;
+
+	proto_tree_add_item(tree, hf_isi_ss_status_indication, tvb, 1, 1, FALSE);
+	proto_tree_add_item(tree, hf_isi_ss_subblock_count, tvb, 2, 1, FALSE);
+	//proto_tree_add_item(tree, hf_isi_ss_subblock, tvb, 3, 1, FALSE);
+	code = tvb_get_guint8(tvb, 1);
+	switch(code) {
+		case 0x00:
+			col_set_str(pinfo->cinfo, COL_INFO, "Status Indication: Request Service Start");
+			break;
+		case 0x01:
+			col_set_str(pinfo->cinfo, COL_INFO, "Status Indication: Request Service Stop");
+			break;
+		case 0x02:
+			col_set_str(pinfo->cinfo, COL_INFO, "Status Indication: Request USSD Start");
+			break;
+		case 0x03:
+			col_set_str(pinfo->cinfo, COL_INFO, "Status Indication: Request USSD Stop");
+			break;
+		default:
+			col_set_str(pinfo->cinfo, COL_INFO, "Status Indication");
+			break;
+	}
+}
+
+static void dissect_isi_ss_service_completed_ind(tvbuff_t *tvb, packet_info *pinfo, proto_item *item, proto_tree *tree) {
+	guint8 code;
+
+	proto_tree_add_item(tree, hf_isi_ss_operation, tvb, 1, 1, FALSE);
+	proto_tree_add_item(tree, hf_isi_ss_service_code, tvb, 2, 1, FALSE);
+	code = tvb_get_guint8(tvb, 1);
+	switch(code) {
+		case 0x05:
+			col_set_str(pinfo->cinfo, COL_INFO, "Service Completed Indication: Interrogation");
+			break;
+		default:
+			col_set_str(pinfo->cinfo, COL_INFO, "Service Completed Indication");
+			break;
+	}
+}
+
+static void dissect_isi_ss_unknown(tvbuff_t *tvb, packet_info *pinfo, proto_item *item, proto_tree *tree) {
+	col_set_str(pinfo->cinfo, COL_INFO, "Unknown type");
+}
+
+void proto_reg_handoff_isi_ss(void) {
+	static gboolean initialized=FALSE;
+
+	if (!initialized) {
+		isi_register_resource(0x06, &hf_isi_ss_message_id, dissect_isi_ss_unknown);
+		isi_register_message(0x06, 0x00, dissect_isi_ss_service_req);
+		isi_register_message(0x06, 0x01, dissect_isi_ss_service_completed_resp);
+		isi_register_message(0x06, 0x02, dissect_isi_ss_service_failed_resp);
+		isi_register_message(0x06, 0x04, dissect_isi_ss_gsm_ussd_send_req);
+		isi_register_message(0x06, 0x05, dissect_isi_ss_gsm_ussd_send_resp);
+		isi_register_message(0x06, 0x06, dissect_isi_ss_gsm_ussd_receive_ind);
+		isi_register_message(0x06, 0x09, dissect_isi_ss_status_ind);
+		isi_register_message(0x06, 0x10, dissect_isi_ss_service_completed_ind);
+
+		isi_register_transaction(0x06, 0x00, 0x01);
+		isi_register_transaction(0x06, 0x00, 0x02);
+		isi_register_transaction(0x06, 0x04, 0x05);
 	}
 }
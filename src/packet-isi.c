@@ -20,20 +20,36 @@
 # include "config.h"
 #endif
 
+#include <string.h>
+#include <stdarg.h>
 #include <glib.h>
 #include <epan/prefs.h>
 #include <epan/packet.h>
+#include <epan/expert.h>
+#include <epan/emem.h>
+#include <epan/exceptions.h>
+#include <epan/tap.h>
+#ifdef ISI_USB
+#include <epan/conversation.h>
+#include <epan/reassemble.h>
+#endif
 
 #include "packet-isi.h"
 #include "isi-network.h"
 #include "isi-sim.h"
 #include "isi-simauth.h"
 #include "isi-gps.h"
+#include "isi-ss.h"
+#include "isi-gss.h"
+#include "isi-sms.h"
 
 #define ISI_LTYPE 0xF5
 
 int proto_isi = -1;
 
+/* Tap publishing an isi_tap_info_t per message */
+static int isi_tap = -1;
+
 /* These are the handles of our subdissectors */
 static dissector_handle_t data_handle=NULL;
 static dissector_handle_t isi_handle;
@@ -41,8 +57,92 @@ static dissector_handle_t isi_handle;
 /* Dissector table for the isi resource */
 static dissector_table_t isi_resource_dissector_table;
 
+/* How far messages of a resource are decoded */
+enum {
+	ISI_DEPTH_HEADER,	/* Phonet header fields only */
+	ISI_DEPTH_SUMMARY,	/* message ID and info column */
+	ISI_DEPTH_FULL		/* complete tree */
+};
+
+static const enum_val_t isi_depth_vals[] = {
+	{"header", "Header", ISI_DEPTH_HEADER},
+	{"summary", "Summary", ISI_DEPTH_SUMMARY},
+	{"full", "Full", ISI_DEPTH_FULL},
+	{NULL, NULL, 0}
+};
+
+/* Resources with a configurable decode depth */
+static const struct {
+	guint8 resource;
+	const char *name;
+	const char *title;
+} isi_depth_prefs[] = {
+	{0x02, "depth_sms", "SMS decode depth"},
+	{0x06, "depth_ss", "Subscriber Services decode depth"},
+	{0x08, "depth_simauth", "SIM Authentication decode depth"},
+	{0x09, "depth_sim", "SIM decode depth"},
+	{0x0A, "depth_network", "Network decode depth"},
+	{0x32, "depth_gss", "General Stack Server decode depth"},
+	{0x54, "depth_gps", "GPS decode depth"}
+};
+
+/* Transaction role of a message */
+#define ISI_MSG_REQUEST  1
+#define ISI_MSG_RESPONSE 2
+
+/* A request and its response, matched by resource, objects and
+ * packet ID on the first pass */
+typedef struct _isi_transaction_t {
+	guint32 req_frame;
+	guint32 resp_frame;
+	nstime_t req_time;
+} isi_transaction_t;
+
+/* Message state built on the first pass, attached to the message tvb */
+typedef struct _isi_msg_data_t {
+	guint32 conv;			/* conversation index */
+	isi_transaction_t *trans;
+	guint16 version;		/* ISI version of the resource, 0 if unknown */
+} isi_msg_data_t;
+
+/* Message dissectors, directly indexed by resource and message ID */
+typedef struct _isi_resource_t {
+	guint32 *hf_msg_id;
+	isi_msg_dissector_t unknown;
+	gint depth;
+	isi_msg_dissector_t msg[256];
+	guint8 kind[256];		/* ISI_MSG_REQUEST or ISI_MSG_RESPONSE */
+} isi_resource_t;
+
+static isi_resource_t *isi_resources[256];
+
+/* Kinds of per-frame data. The same raw offset can carry a USB segment
+ * list, message state and a content cache, and reassembled messages have
+ * offsets of their own, so entries are matched on kind, source and offset. */
+#define ISI_FD_USB	0	/* isi_usb_segment_t list of a bulk transfer */
+#define ISI_FD_MSG	1	/* isi_msg_data_t at the message header */
+#define ISI_FD_CONTENT	2	/* resource cache at the message content */
+
+/* Cached message data of a frame, one entry per message */
+typedef struct _isi_frame_data_t {
+	guint8 kind;
+	guint32 source;
+	gint offset;
+	gpointer data;
+	struct _isi_frame_data_t *next;
+} isi_frame_data_t;
+
+/* Where the messages being dissected come from: 0 for the frame itself,
+ * else the reassembly ID of the reassembled message */
+static guint32 isi_frame_source;
+
+static gpointer isi_find_frame_data(packet_info *pinfo, guint8 kind, gint offset);
+static void isi_add_kind_data(packet_info *pinfo, guint8 kind, gint offset, gpointer data);
+
 /* Forward-declare the dissector functions */
 static void dissect_isi(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree);
+static void dissect_isi_messages(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, guint *count);
+static void isi_col_next_message(packet_info *pinfo, guint *count);
 
 static const value_string hf_isi_device[] = {
 	{0x00, "Modem" },
@@ -65,7 +165,19 @@ static const value_string hf_isi_resource[] = {
 	{0x32, "General Stack Server"}, /* Mysterious type 50 - I don't know what this is*/
 	{0x54, "GPS"},
 	{0x62, "EPOC Info"},
-	{0xB4, "Radio Settings"} /* Mysterious type 180? */
+	{0xB4, "Radio Settings"}, /* Mysterious type 180? */
+	{0x00, NULL}
+};
+static value_string_ext hf_isi_resource_ext = VALUE_STRING_EXT_INIT(hf_isi_resource);
+
+#define ISI_COMMON_MESSAGE 0xF0
+
+static const value_string isi_common_message_id[] = {
+	{0x01, "COMM_SERVICE_NOT_IDENTIFIED_RESP"},
+	{0x12, "COMM_ISI_VERSION_GET_REQ"},
+	{0x13, "COMM_ISI_VERSION_GET_RESP"},
+	{0x14, "COMM_ISA_ENTITY_NOT_REACHABLE_RESP"},
+	{0x00, NULL}
 };
 
 static guint32 hf_isi_rdev = -1;
@@ -75,6 +187,53 @@ static guint32 hf_isi_len  = -1;
 static guint32 hf_isi_robj = -1;
 static guint32 hf_isi_sobj = -1;
 static guint32 hf_isi_id   = -1;
+static guint32 hf_isi_conv = -1;
+static guint32 hf_isi_response_in = -1;
+static guint32 hf_isi_request_in = -1;
+static guint32 hf_isi_no_response = -1;
+static guint32 hf_isi_time = -1;
+static guint32 hf_isi_common_msg_id = -1;
+static guint32 hf_isi_common_related_msg_id = -1;
+static guint32 hf_isi_common_version_major = -1;
+static guint32 hf_isi_common_version_minor = -1;
+static guint32 hf_isi_version = -1;
+
+/* ISI version (major << 8 | minor) each resource reported so far, kept
+ * in capture order on the first pass */
+static guint16 isi_versions[256];
+
+/* Occurrences of one expert info key in this capture. The format string
+ * of the call site tells problems of the same message apart. */
+typedef struct _isi_expert_stat_t {
+	guint32 key;		/* resource, message and subblock */
+	int group;
+	int severity;
+	const char *format;
+
+	guint32 count;
+	guint32 first_frame;
+	guint32 last_frame;
+	guint32 limit_frame;	/* frame of the last occurrence listed in full */
+	guint32 summary_frame;	/* frame carrying the summary item */
+} isi_expert_stat_t;
+
+static GHashTable *isi_expert_stats = NULL;
+
+/* Capture scoped pool of decoded strings, keyed by their raw bytes */
+typedef struct _isi_string_key_t {
+	guint len;
+	const guint8 *data;
+} isi_string_key_t;
+
+static GHashTable *isi_strings = NULL;
+
+/* Open transactions of the first pass, by isi_transaction_key() */
+static GHashTable *isi_transactions = NULL;
+
+/* Conversation index + 1 by endpoint pair, see isi_conversation_index() */
+static GHashTable *isi_conversations = NULL;
+static guint32 isi_conversation_count = 0;
+static guint isi_expert_limit = 10;
 
 /* Subtree handles: set by register_subtree_array */
 static guint32 ett_isi = -1;
@@ -82,20 +241,629 @@ guint32 ett_isi_msg = -1;
 guint32 ett_isi_network_gsm_band_info = -1;
 
 #ifdef ISI_USB
-/* Experimental approach based upon the one used for PPP*/
+/* cdc-phonet prefixes every message with a media byte. The Phonet
+ * length field covers everything after it, so a message is len + 6
+ * bytes long including the media byte. */
+#define ISI_USB_MEDIA 0x1B
+#define ISI_USB_HDR_LEN 6
+
+/* reassembly of messages spanning bulk transfers */
+static GHashTable *isi_usb_fragment_table = NULL;
+static GHashTable *isi_usb_reassembled_table = NULL;
+
+static int hf_isi_fragments = -1;
+static int hf_isi_fragment = -1;
+static int hf_isi_fragment_overlap = -1;
+static int hf_isi_fragment_overlap_conflicts = -1;
+static int hf_isi_fragment_multiple_tails = -1;
+static int hf_isi_fragment_too_long_fragment = -1;
+static int hf_isi_fragment_error = -1;
+static int hf_isi_fragment_count = -1;
+static int hf_isi_reassembled_in = -1;
+static int hf_isi_reassembled_length = -1;
+static gint ett_isi_fragment = -1;
+static gint ett_isi_fragments = -1;
+
+static const fragment_items isi_frag_items = {
+	&ett_isi_fragment,
+	&ett_isi_fragments,
+	&hf_isi_fragments,
+	&hf_isi_fragment,
+	&hf_isi_fragment_overlap,
+	&hf_isi_fragment_overlap_conflicts,
+	&hf_isi_fragment_multiple_tails,
+	&hf_isi_fragment_too_long_fragment,
+	&hf_isi_fragment_error,
+	&hf_isi_fragment_count,
+	&hf_isi_reassembled_in,
+	&hf_isi_reassembled_length,
+	"ISI fragments"
+};
+
+/* unfinished message of one transfer direction */
+typedef struct _isi_usb_stream_t {
+	guint32 msg_id;		/* frame number of the first fragment */
+	guint32 collected;	/* bytes received so far */
+	guint32 pending;	/* bytes still missing */
+	guint8 hdr[ISI_USB_HDR_LEN];	/* header cut by the end of a transfer */
+	guint32 hdr_len;	/* bytes of hdr received, 0 once complete */
+} isi_usb_stream_t;
+
+/* per USB conversation, stream[0] is the direction of conv->src */
+typedef struct _isi_usb_conv_t {
+	address src;
+	guint32 srcport;
+	gboolean pinned;	/* endpoint is known to carry ISI */
+	isi_usb_stream_t stream[2];
+} isi_usb_conv_t;
+
+/* number of pinned USB conversations, no lookups are done while zero */
+static guint isi_usb_pinned = 0;
+
+/* one message or message fragment within a bulk transfer, computed
+ * on the first pass, since the stream state is only valid then */
+typedef struct _isi_usb_segment_t {
+	guint32 offset;
+	guint32 len;
+	guint32 msg_id;		/* 0 for messages complete within the transfer */
+	guint32 frag_offset;
+	gboolean more;
+	struct _isi_usb_segment_t *next;
+} isi_usb_segment_t;
+#endif
+
+#ifdef ISI_USB
+static void isi_usb_init(void) {
+	isi_usb_pinned = 0;
+	fragment_table_init(&isi_usb_fragment_table);
+	reassembled_table_init(&isi_usb_reassembled_table);
+}
+
+static isi_usb_conv_t *isi_usb_get_conv(packet_info *pinfo, gboolean create) {
+	conversation_t *conv;
+	isi_usb_conv_t *data;
+
+	conv = find_conversation(pinfo->fd->num, &pinfo->src, &pinfo->dst, pinfo->ptype, pinfo->srcport, pinfo->destport, 0);
+	if(!conv) {
+		if(!create)
+			return NULL;
+		conv = conversation_new(pinfo->fd->num, &pinfo->src, &pinfo->dst, pinfo->ptype, pinfo->srcport, pinfo->destport, 0);
+	}
+
+	data = conversation_get_proto_data(conv, proto_isi);
+	if(!data && create) {
+		data = se_new0(isi_usb_conv_t);
+		SE_COPY_ADDRESS(&data->src, &pinfo->src);
+		data->srcport = pinfo->srcport;
+		conversation_add_proto_data(conv, proto_isi, data);
+	}
+
+	return data;
+}
+
+static isi_usb_stream_t *isi_usb_get_stream(isi_usb_conv_t *conv, packet_info *pinfo) {
+	if(ADDRESSES_EQUAL(&conv->src, &pinfo->src) && conv->srcport == pinfo->srcport)
+		return &conv->stream[0];
+	return &conv->stream[1];
+}
+
+/* Cheap check of the first Phonet header in a transfer, this runs for
+ * every bulk frame of every device until an endpoint is pinned */
+static gboolean isi_usb_validate(tvbuff_t *tvb) {
+	const guint8 *hdr;
+	guint32 length = tvb_length(tvb);
+	guint32 msglen;
+
+	if(length < ISI_USB_HDR_LEN + 3)
+		return FALSE;
+
+	hdr = tvb_get_ptr(tvb, 0, ISI_USB_HDR_LEN + 3);
+	if(hdr[0] != ISI_USB_MEDIA)
+		return FALSE;
+
+	/* receiver and sender must be known devices, see hf_isi_device */
+	if((hdr[1] != 0x00 && hdr[1] != 0x6c && hdr[1] != 0xFF) ||
+	   (hdr[2] != 0x00 && hdr[2] != 0x6c && hdr[2] != 0xFF))
+		return FALSE;
+
+	/* the length covers at least objects and message id, and must either
+	 * end the transfer, be followed by another message, or continue */
+	msglen = pntohs(hdr+4);
+	if(msglen < 3)
+		return FALSE;
+	msglen += ISI_USB_HDR_LEN;
+
+	return msglen >= length || tvb_get_guint8(tvb, msglen) == ISI_USB_MEDIA;
+}
+
+static isi_usb_segment_t *isi_usb_add_segment(isi_usb_segment_t **tail, guint32 offset, guint32 len) {
+	isi_usb_segment_t *seg = se_new0(isi_usb_segment_t);
+
+	seg->offset = offset;
+	seg->len = len;
+	*tail = seg;
+
+	return seg;
+}
+
+/* Split a bulk transfer into the messages it carries. Concatenated
+ * messages are cut out as they are, a message running past the end of
+ * the transfer is continued by the following transfers. */
+static isi_usb_segment_t *isi_usb_split(tvbuff_t *tvb, packet_info *pinfo, isi_usb_conv_t *conv) {
+	isi_usb_stream_t *stream = isi_usb_get_stream(conv, pinfo);
+	isi_usb_segment_t *head = NULL, **tail = &head, *seg;
+	guint32 length = tvb_length(tvb);
+	guint32 offset = 0;
+	guint32 msglen;
+
+	/* the previous transfer ended within a header, its length decides
+	 * how much of this transfer still belongs to that message */
+	if(stream->hdr_len) {
+		msglen = MIN(ISI_USB_HDR_LEN - stream->hdr_len, length);
+		tvb_memcpy(tvb, stream->hdr + stream->hdr_len, 0, msglen);
+		stream->hdr_len += msglen;
+
+		if(stream->hdr_len < ISI_USB_HDR_LEN) {
+			seg = isi_usb_add_segment(tail, 0, msglen);
+			seg->msg_id = stream->msg_id;
+			seg->frag_offset = stream->collected;
+			seg->more = TRUE;
+
+			stream->collected += msglen;
+			return head;
+		}
+
+		stream->pending = pntohs(stream->hdr+4) + ISI_USB_HDR_LEN - stream->collected;
+		stream->hdr_len = 0;
+	}
+
+	if(stream->pending) {
+		msglen = MIN(stream->pending, length);
+
+		seg = isi_usb_add_segment(tail, 0, msglen);
+		seg->msg_id = stream->msg_id;
+		seg->frag_offset = stream->collected;
+		seg->more = msglen < stream->pending;
+		tail = &seg->next;
+
+		stream->collected += msglen;
+		stream->pending -= msglen;
+		offset = msglen;
+	}
+
+	while(offset + ISI_USB_HDR_LEN <= length && tvb_get_guint8(tvb, offset) == ISI_USB_MEDIA) {
+		msglen = tvb_get_ntohs(tvb, offset+4) + ISI_USB_HDR_LEN;
+
+		if(offset + msglen <= length) {
+			seg = isi_usb_add_segment(tail, offset, msglen);
+			tail = &seg->next;
+			offset += msglen;
+			continue;
+		}
+
+		seg = isi_usb_add_segment(tail, offset, length - offset);
+		seg->msg_id = pinfo->fd->num;
+		seg->more = TRUE;
+		tail = &seg->next;
+
+		stream->msg_id = pinfo->fd->num;
+		stream->collected = length - offset;
+		stream->pending = msglen - (length - offset);
+		offset = length;
+	}
+
+	/* not even the header fits, it is completed by the next transfer */
+	if(offset < length && tvb_get_guint8(tvb, offset) == ISI_USB_MEDIA) {
+		seg = isi_usb_add_segment(tail, offset, length - offset);
+		seg->msg_id = pinfo->fd->num;
+		seg->more = TRUE;
+
+		stream->msg_id = pinfo->fd->num;
+		stream->collected = length - offset;
+		stream->pending = 0;
+		stream->hdr_len = length - offset;
+		tvb_memcpy(tvb, stream->hdr, offset, stream->hdr_len);
+		return head;
+	}
+
+	/* anything left over is not ISI, hand it to the data dissector */
+	if(offset < length)
+		isi_usb_add_segment(tail, offset, length - offset);
+
+	return head;
+}
+
 static gboolean dissect_usb_isi(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree) {
-	tvbuff_t *next_tvb = NULL;
+	isi_usb_conv_t *conv = NULL;
+	isi_usb_segment_t *seg;
+	fragment_data *fd_head;
+	tvbuff_t *next_tvb;
+	guint count = 0;
+
+	/* an exception in a reassembled message skips the reset below */
+	isi_frame_source = 0;
+
+	if(!pinfo->fd->flags.visited) {
+		/* pinned endpoints skip the heuristic, which also lets message
+		 * continuations without media byte through */
+		if(isi_usb_pinned)
+			conv = isi_usb_get_conv(pinfo, FALSE);
+
+		if(!conv || !conv->pinned) {
+			if(!isi_usb_validate(tvb))
+				return (FALSE);
+
+			conv = isi_usb_get_conv(pinfo, TRUE);
+			conv->pinned = TRUE;
+			isi_usb_pinned++;
+		}
 
-	if(tvb_get_guint8(tvb, 0) == 0x1B) {
-		next_tvb = tvb_new_subset_remaining(tvb, 1);
-		dissect_isi(next_tvb, pinfo, tree);
+		seg = isi_usb_split(tvb, pinfo, conv);
+		isi_add_kind_data(pinfo, ISI_FD_USB, tvb_raw_offset(tvb), seg);
+	} else {
+		seg = isi_find_frame_data(pinfo, ISI_FD_USB, tvb_raw_offset(tvb));
+		if(!seg)
+			return (FALSE);
 	}
-	else
-		return (FALSE);
+
+	if(check_col(pinfo->cinfo, COL_PROTOCOL))
+		col_set_str(pinfo->cinfo, COL_PROTOCOL, "ISI");
+
+	if(check_col(pinfo->cinfo,COL_INFO))
+		col_clear(pinfo->cinfo,COL_INFO);
+
+	for(; seg; seg = seg->next) {
+		if(!seg->msg_id) {
+			if(tvb_get_guint8(tvb, seg->offset) == ISI_USB_MEDIA)
+				dissect_isi_messages(tvb_new_subset(tvb, seg->offset+1, seg->len-1, seg->len-1), pinfo, tree, &count);
+			else
+				call_dissector(data_handle, tvb_new_subset(tvb, seg->offset, seg->len, seg->len), pinfo, tree);
+			continue;
+		}
+
+		fd_head = fragment_add(tvb, seg->offset, pinfo, seg->msg_id, isi_usb_fragment_table, seg->frag_offset, seg->len, seg->more);
+		next_tvb = process_reassembled_data(tvb, seg->offset, pinfo, "Reassembled ISI", fd_head, &isi_frag_items, NULL, tree);
+
+		if(next_tvb) {
+			isi_frame_source = seg->msg_id;
+			dissect_isi_messages(tvb_new_subset_remaining(next_tvb, 1), pinfo, tree, &count);
+			isi_frame_source = 0;
+		} else {
+			isi_col_next_message(pinfo, &count);
+			col_set_str(pinfo->cinfo, COL_INFO, "ISI fragment");
+			proto_tree_add_text(tree, tvb, seg->offset, seg->len, "ISI fragment (%u bytes)", seg->len);
+		}
+	}
+
 	return (TRUE);
 }
 #endif
 
+static guint isi_string_hash(gconstpointer k) {
+	const isi_string_key_t *key = k;
+	guint hash = 2166136261u;	/* FNV-1a */
+	guint i;
+
+	for(i=0; i<key->len; i++)
+		hash = (hash ^ key->data[i]) * 16777619u;
+
+	return hash;
+}
+
+static gboolean isi_string_equal(gconstpointer a, gconstpointer b) {
+	const isi_string_key_t *ka = a, *kb = b;
+
+	return ka->len == kb->len && !memcmp(ka->data, kb->data, ka->len);
+}
+
+static guint isi_expert_hash(gconstpointer k) {
+	const isi_expert_stat_t *st = k;
+
+	/* group and severity use the high bits, the key the low 24 */
+	return st->key ^ (guint) st->group ^ (guint) st->severity ^ g_direct_hash(st->format);
+}
+
+static gboolean isi_expert_equal(gconstpointer a, gconstpointer b) {
+	const isi_expert_stat_t *sa = a, *sb = b;
+
+	return sa->key == sb->key && sa->group == sb->group && sa->severity == sb->severity && sa->format == sb->format;
+}
+
+static void isi_init(void) {
+	memset(isi_versions, 0, sizeof(isi_versions));
+
+	if(isi_expert_stats)
+		g_hash_table_destroy(isi_expert_stats);
+	isi_expert_stats = g_hash_table_new_full(isi_expert_hash, isi_expert_equal, NULL, g_free);
+
+	/* keys and strings are se_alloc'ed and go away with the capture */
+	if(isi_strings)
+		g_hash_table_destroy(isi_strings);
+	isi_strings = g_hash_table_new(isi_string_hash, isi_string_equal);
+
+	if(isi_transactions)
+		g_hash_table_destroy(isi_transactions);
+	isi_transactions = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+	if(isi_conversations)
+		g_hash_table_destroy(isi_conversations);
+	isi_conversations = g_hash_table_new(g_direct_hash, g_direct_equal);
+	isi_conversation_count = 0;
+}
+
+void isi_expert_add(packet_info *pinfo, proto_item *item, int group, int severity, guint8 resource, guint8 msg_id, guint8 subblock, const char *format, ...) {
+	guint32 num = pinfo->fd->num;
+	isi_expert_stat_t lookup, *st;
+	const char *msg;
+	va_list ap;
+
+	lookup.key = (resource << 16) | (msg_id << 8) | subblock;
+	lookup.group = group;
+	lookup.severity = severity;
+	lookup.format = format;
+
+	st = g_hash_table_lookup(isi_expert_stats, &lookup);
+	if(!st) {
+		st = g_new0(isi_expert_stat_t, 1);
+		*st = lookup;
+		st->first_frame = num;
+		g_hash_table_insert(isi_expert_stats, st, st);
+	}
+
+	/* every frame is counted once, in capture order */
+	if(num > st->last_frame) {
+		st->count++;
+		st->last_frame = num;
+
+		if(!isi_expert_limit || st->count <= isi_expert_limit)
+			st->limit_frame = num;
+		else if(!st->summary_frame)
+			st->summary_frame = num;
+	}
+
+	if(num > st->limit_frame && num != st->summary_frame)
+		return;
+
+	va_start(ap, format);
+	msg = ep_strdup_vprintf(format, ap);
+	va_end(ap);
+
+	/* the totals are only known once the first pass is complete */
+	if(num <= st->limit_frame)
+		expert_add_info_format(pinfo, item, group, severity, "%s", msg);
+	else if(!pinfo->fd->flags.visited)
+		expert_add_info_format(pinfo, item, group, severity, "%s (further occurrences suppressed, only the first %u are listed)",
+			msg, isi_expert_limit);
+	else
+		expert_add_info_format(pinfo, item, group, severity, "%s (%u occurrences in frames %u-%u, only the first %u are listed)",
+			msg, st->count, st->first_frame, st->last_frame, isi_expert_limit);
+}
+
+static isi_resource_t *isi_get_resource(guint8 resource) {
+	isi_resource_t *res = isi_resources[resource];
+
+	if(!res) {
+		res = g_new0(isi_resource_t, 1);
+		res->depth = ISI_DEPTH_FULL;
+		isi_resources[resource] = res;
+	}
+
+	return res;
+}
+
+void isi_register_resource(guint8 resource, guint32 *hf_msg_id, isi_msg_dissector_t unknown) {
+	isi_resource_t *res = isi_get_resource(resource);
+
+	res->hf_msg_id = hf_msg_id;
+	res->unknown = unknown;
+}
+
+void isi_register_message(guint8 resource, guint8 msg_id, isi_msg_dissector_t dissector) {
+	isi_get_resource(resource)->msg[msg_id] = dissector;
+}
+
+const gchar *isi_resource_name(guint8 resource) {
+	return val_to_str_ext_const(resource, &hf_isi_resource_ext, "Unknown");
+}
+
+const gchar *isi_message_name(guint8 resource, guint8 msg_id) {
+	isi_resource_t *res = isi_resources[resource];
+	header_field_info *hfinfo;
+
+	if(msg_id == ISI_COMMON_MESSAGE)
+		return "COMMON_MESSAGE";
+	if(!res || !res->hf_msg_id || *res->hf_msg_id == (guint32) -1)
+		return "Unknown";
+
+	hfinfo = proto_registrar_get_nth(*res->hf_msg_id);
+	if(hfinfo->display & BASE_EXT_STRING)
+		return val_to_str_ext_const(msg_id, (value_string_ext *) hfinfo->strings, "Unknown");
+
+	return val_to_str_const(msg_id, (const value_string *) hfinfo->strings, "Unknown");
+}
+
+void isi_register_transaction(guint8 resource, guint8 req_id, guint8 resp_id) {
+	isi_resource_t *res = isi_get_resource(resource);
+
+	res->kind[req_id] = ISI_MSG_REQUEST;
+	res->kind[resp_id] = ISI_MSG_RESPONSE;
+}
+
+static gpointer isi_find_frame_data(packet_info *pinfo, guint8 kind, gint offset) {
+	isi_frame_data_t *fd = p_get_proto_data(pinfo->fd, proto_isi);
+
+	for(; fd; fd = fd->next)
+		if(fd->kind == kind && fd->source == isi_frame_source && fd->offset == offset)
+			return fd->data;
+
+	return NULL;
+}
+
+static void isi_add_kind_data(packet_info *pinfo, guint8 kind, gint offset, gpointer data) {
+	isi_frame_data_t *head = p_get_proto_data(pinfo->fd, proto_isi);
+	isi_frame_data_t *fd = se_new(isi_frame_data_t);
+
+	fd->kind = kind;
+	fd->source = isi_frame_source;
+	fd->offset = offset;
+	fd->data = data;
+
+	/* the list head is owned by the frame, append behind it */
+	if(head) {
+		fd->next = head->next;
+		head->next = fd;
+	} else {
+		fd->next = NULL;
+		p_add_proto_data(pinfo->fd, proto_isi, fd);
+	}
+}
+
+gpointer isi_get_frame_data(packet_info *pinfo, tvbuff_t *tvb) {
+	return isi_find_frame_data(pinfo, ISI_FD_CONTENT, tvb_raw_offset(tvb));
+}
+
+gboolean isi_get_response(packet_info *pinfo, tvbuff_t *tvb, guint32 *request_in, nstime_t *time) {
+	/* message data lives at the header, 8 bytes before the content */
+	isi_msg_data_t *md = isi_find_frame_data(pinfo, ISI_FD_MSG, tvb_raw_offset(tvb) - 8);
+
+	if(!md || !md->trans || md->trans->resp_frame != pinfo->fd->num)
+		return FALSE;
+
+	*request_in = md->trans->req_frame;
+	nstime_delta(time, &pinfo->fd->abs_ts, &md->trans->req_time);
+	return TRUE;
+}
+
+void isi_add_frame_data(packet_info *pinfo, tvbuff_t *tvb, gpointer data) {
+	isi_add_kind_data(pinfo, ISI_FD_CONTENT, tvb_raw_offset(tvb), data);
+}
+
+const char *isi_ucs2_to_utf8(tvbuff_t *tvb, gint offset, guint len) {
+	/* high bytes and bit 7 of the low bytes of four UCS-2 characters */
+	static const guint8 nonascii[8] = { 0xFF, 0x80, 0xFF, 0x80, 0xFF, 0x80, 0xFF, 0x80 };
+	const guint8 *in;
+	char *out;
+	guint64 mask, w;
+	guint i = 0, o = 0;
+	gunichar c, c2;
+
+	if(!len)
+		return "";
+
+	in = tvb_get_ptr(tvb, offset, len*2);
+	out = ep_alloc(len*3 + 1);
+
+	memcpy(&mask, nonascii, sizeof(mask));
+
+	/* ASCII fast path, four characters per step */
+	for(; i + 4 <= len; i += 4, o += 4) {
+		memcpy(&w, in + i*2, sizeof(w));
+		if(w & mask)
+			break;
+
+		out[o+0] = in[i*2+1];
+		out[o+1] = in[i*2+3];
+		out[o+2] = in[i*2+5];
+		out[o+3] = in[i*2+7];
+
+		/* a NUL character terminates the string */
+		if(!out[o+0] || !out[o+1] || !out[o+2] || !out[o+3]) {
+			out[o+4] = 0x00;
+			return out;
+		}
+	}
+
+	for(; i < len; i++) {
+		c = pntohs(in + i*2);
+		if(!c)
+			break;
+
+		if(c < 0x80) {
+			out[o++] = c;
+			continue;
+		}
+
+		if(c >= 0xD800 && c <= 0xDBFF && i + 1 < len) {
+			c2 = pntohs(in + (i+1)*2);
+			if(c2 >= 0xDC00 && c2 <= 0xDFFF) {
+				c = 0x10000 + ((c - 0xD800) << 10) + (c2 - 0xDC00);
+				i++;
+			}
+		}
+
+		/* lone surrogates are replaced */
+		if(c >= 0xD800 && c <= 0xDFFF)
+			c = 0xFFFD;
+
+		o += g_unichar_to_utf8(c, out + o);
+	}
+
+	out[o] = 0x00;
+	return out;
+}
+
+const char *isi_ucs2_intern(tvbuff_t *tvb, gint offset, guint len) {
+	isi_string_key_t key, *stored;
+	char *str;
+
+	if(!len)
+		return "";
+
+	key.len = len*2;
+	key.data = tvb_get_ptr(tvb, offset, key.len);
+
+	str = g_hash_table_lookup(isi_strings, &key);
+	if(str)
+		return str;
+
+	stored = se_new(isi_string_key_t);
+	stored->len = key.len;
+	stored->data = se_memdup(key.data, key.len);
+	str = se_strdup(isi_ucs2_to_utf8(tvb, offset, len));
+	g_hash_table_insert(isi_strings, stored, str);
+
+	return str;
+}
+
+void isi_subblock_iter_init(isi_subblock_iter_t *it, tvbuff_t *tvb, guint offset, guint count, guint8 hdr_len, guint8 type_offset, guint8 len_offset) {
+	it->tvb = tvb;
+	it->offset = offset;
+	it->count = count;
+	it->hdr_len = hdr_len;
+	it->type_offset = type_offset;
+	it->len_offset = len_offset;
+	it->malformed = FALSE;
+}
+
+gboolean isi_subblock_iter_next(isi_subblock_iter_t *it) {
+	guint remaining;
+	const guint8 *hdr;
+
+	if(!it->count || it->malformed)
+		return FALSE;
+
+	remaining = tvb_length(it->tvb) > it->offset ? tvb_length(it->tvb) - it->offset : 0;
+	if(remaining < it->hdr_len) {
+		it->malformed = TRUE;
+		return FALSE;
+	}
+
+	hdr = tvb_get_ptr(it->tvb, it->offset, it->hdr_len);
+	if(hdr[it->len_offset] < it->hdr_len || hdr[it->len_offset] > remaining) {
+		it->malformed = TRUE;
+		return FALSE;
+	}
+
+	it->block_offset = it->offset;
+	it->type = hdr[it->type_offset];
+	it->len = hdr[it->len_offset];
+
+	it->offset += it->len;
+	it->count--;
+
+	return TRUE;
+}
+
 /* Handler registration */
 void proto_reg_handoff_isi(void) {
 	static gboolean initialized=FALSE;
@@ -121,6 +889,9 @@ void proto_reg_handoff_isi(void) {
 }
 
 void proto_register_isi(void) {
+	module_t *isi_module;
+	guint i;
+
 	/* A header field is something you can search/filter on.
 	 * 
 	 * We create a structure to register our fields. It consists of an
@@ -135,8 +906,8 @@ void proto_register_isi(void) {
 		  { "Sender Device", "isi.sdev", FT_UINT8, BASE_HEX,
 		    VALS(hf_isi_device), 0x0, "Sender Device ID", HFILL }},
 		{ &hf_isi_res,
-		  { "Resource", "isi.res", FT_UINT8, BASE_HEX,
-		    VALS(hf_isi_resource), 0x0, "Resource ID", HFILL }},
+		  { "Resource", "isi.res", FT_UINT8, BASE_HEX|BASE_EXT_STRING,
+		    &hf_isi_resource_ext, 0x0, "Resource ID", HFILL }},
 		{ &hf_isi_len,
 		  { "Length", "isi.len", FT_UINT16, BASE_DEC,
 		    NULL, 0x0, "Length", HFILL }},
@@ -148,7 +919,37 @@ void proto_register_isi(void) {
 		    NULL, 0x0, "Sender Object", HFILL }},
 		{ &hf_isi_id,
 		  { "Packet ID", "isi.id", FT_UINT8, BASE_DEC,
-		    NULL, 0x0, "Packet ID", HFILL }}
+		    NULL, 0x0, "Packet ID", HFILL }},
+		{ &hf_isi_conv,
+		  { "Conversation", "isi.conv", FT_UINT32, BASE_DEC,
+		    NULL, 0x0, "Index of the (device, object) pair conversation", HFILL }},
+		{ &hf_isi_version,
+		  { "ISI Version", "isi.version", FT_STRING, BASE_NONE,
+		    NULL, 0x0, "Last ISI version reported by this resource before this message", HFILL }},
+		{ &hf_isi_response_in,
+		  { "Response In", "isi.response_in", FT_FRAMENUM, BASE_NONE,
+		    NULL, 0x0, "The response to this request is in this frame", HFILL }},
+		{ &hf_isi_request_in,
+		  { "Request In", "isi.request_in", FT_FRAMENUM, BASE_NONE,
+		    NULL, 0x0, "This is a response to the request in this frame", HFILL }},
+		{ &hf_isi_no_response,
+		  { "No response seen", "isi.no_response", FT_NONE, BASE_NONE,
+		    NULL, 0x0, "No response to this request in the capture, only known on a second pass (tshark -2)", HFILL }},
+		{ &hf_isi_time,
+		  { "Time", "isi.time", FT_RELATIVE_TIME, BASE_NONE,
+		    NULL, 0x0, "Time between request and response", HFILL }},
+		{ &hf_isi_common_msg_id,
+		  { "Common Message ID", "isi.common.msg_id", FT_UINT8, BASE_HEX,
+		    VALS(isi_common_message_id), 0x0, "Common Message ID", HFILL }},
+		{ &hf_isi_common_related_msg_id,
+		  { "Related Message ID", "isi.common.related_msg_id", FT_UINT8, BASE_HEX,
+		    NULL, 0x0, "Message ID the common message refers to", HFILL }},
+		{ &hf_isi_common_version_major,
+		  { "ISI Version Major", "isi.common.version.major", FT_UINT8, BASE_DEC,
+		    NULL, 0x0, "ISI Version Major", HFILL }},
+		{ &hf_isi_common_version_minor,
+		  { "ISI Version Minor", "isi.common.version.minor", FT_UINT8, BASE_DEC,
+		    NULL, 0x0, "ISI Version Minor", HFILL }}
     };
 
 	static gint *ett[] = {
@@ -162,6 +963,64 @@ void proto_register_isi(void) {
 	proto_register_field_array(proto_isi, hf, array_length(hf));
 	proto_register_subtree_array(ett, array_length(ett));
 	register_dissector("isi", dissect_isi, proto_isi);
+	register_init_routine(isi_init);
+	isi_tap = register_tap("isi");
+
+#ifdef ISI_USB
+	{
+		static hf_register_info hf_usb[] = {
+			{ &hf_isi_fragments,
+			  { "Message fragments", "isi.fragments", FT_NONE, BASE_NONE,
+			    NULL, 0x0, NULL, HFILL }},
+			{ &hf_isi_fragment,
+			  { "Message fragment", "isi.fragment", FT_FRAMENUM, BASE_NONE,
+			    NULL, 0x0, NULL, HFILL }},
+			{ &hf_isi_fragment_overlap,
+			  { "Message fragment overlap", "isi.fragment.overlap", FT_BOOLEAN, BASE_NONE,
+			    NULL, 0x0, NULL, HFILL }},
+			{ &hf_isi_fragment_overlap_conflicts,
+			  { "Message fragment overlapping with conflicting data", "isi.fragment.overlap.conflicts", FT_BOOLEAN, BASE_NONE,
+			    NULL, 0x0, NULL, HFILL }},
+			{ &hf_isi_fragment_multiple_tails,
+			  { "Message has multiple tail fragments", "isi.fragment.multiple_tails", FT_BOOLEAN, BASE_NONE,
+			    NULL, 0x0, NULL, HFILL }},
+			{ &hf_isi_fragment_too_long_fragment,
+			  { "Message fragment too long", "isi.fragment.too_long_fragment", FT_BOOLEAN, BASE_NONE,
+			    NULL, 0x0, NULL, HFILL }},
+			{ &hf_isi_fragment_error,
+			  { "Message defragmentation error", "isi.fragment.error", FT_FRAMENUM, BASE_NONE,
+			    NULL, 0x0, NULL, HFILL }},
+			{ &hf_isi_fragment_count,
+			  { "Message fragment count", "isi.fragment.count", FT_UINT32, BASE_DEC,
+			    NULL, 0x0, NULL, HFILL }},
+			{ &hf_isi_reassembled_in,
+			  { "Reassembled in", "isi.reassembled.in", FT_FRAMENUM, BASE_NONE,
+			    NULL, 0x0, NULL, HFILL }},
+			{ &hf_isi_reassembled_length,
+			  { "Reassembled length", "isi.reassembled.length", FT_UINT32, BASE_DEC,
+			    NULL, 0x0, NULL, HFILL }}
+		};
+
+		static gint *ett_usb[] = {
+			&ett_isi_fragment,
+			&ett_isi_fragments
+		};
+
+		proto_register_field_array(proto_isi, hf_usb, array_length(hf_usb));
+		proto_register_subtree_array(ett_usb, array_length(ett_usb));
+		register_init_routine(isi_usb_init);
+	}
+#endif
+
+	isi_module = prefs_register_protocol(proto_isi, NULL);
+	for(i=0; i<array_length(isi_depth_prefs); i++)
+		prefs_register_enum_preference(isi_module, isi_depth_prefs[i].name, isi_depth_prefs[i].title,
+			"Header adds the Phonet header only, Summary adds the message ID and info column, Full decodes the complete message",
+			&isi_get_resource(isi_depth_prefs[i].resource)->depth, isi_depth_vals, FALSE);
+
+	prefs_register_uint_preference(isi_module, "expert_limit", "Expert info per problem",
+		"Number of frames listed in expert info for each kind of problem before they are summarized, 0 lists all",
+		10, &isi_expert_limit);
 
 	/* create new dissector table for isi resource */
 	isi_resource_dissector_table = register_dissector_table("isi.resource", "ISI resource", FT_UINT8, BASE_HEX);
@@ -176,33 +1035,184 @@ void proto_register_isi(void) {
 	proto_register_isi_sms();
 }
 
-/* The dissector itself */
-static void dissect_isi(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree) {
+/* Messages after the first one of a frame are appended to the info
+ * column, the fence keeps col_set_str() from overwriting earlier ones */
+static void isi_col_next_message(packet_info *pinfo, guint *count) {
+	if((*count)++) {
+		col_append_str(pinfo->cinfo, COL_INFO, " | ");
+		col_set_fence(pinfo->cinfo, COL_INFO);
+	}
+}
+
+static void dissect_isi_common(tvbuff_t *tvb, packet_info *pinfo, proto_item *item, proto_tree *tree) {
+	guint8 code = tvb_get_guint8(tvb, 1);
+	guint8 major, minor;
+
+	proto_tree_add_item(tree, hf_isi_common_msg_id, tvb, 1, 1, FALSE);
+
+	switch(code) {
+		case 0x01: /* COMM_SERVICE_NOT_IDENTIFIED_RESP */
+			col_set_str(pinfo->cinfo, COL_INFO, "Common Message: Service Not Identified Response");
+			proto_tree_add_item(tree, hf_isi_common_related_msg_id, tvb, 2, 1, FALSE);
+			break;
+		case 0x12: /* COMM_ISI_VERSION_GET_REQ */
+			col_set_str(pinfo->cinfo, COL_INFO, "Common Message: ISI Version Get Request");
+			break;
+		case 0x13: /* COMM_ISI_VERSION_GET_RESP */
+			major = tvb_get_guint8(tvb, 2);
+			minor = tvb_get_guint8(tvb, 3);
+			col_add_fstr(pinfo->cinfo, COL_INFO, "Common Message: ISI Version Get Response (%d.%d)", major, minor);
+			proto_tree_add_item(tree, hf_isi_common_version_major, tvb, 2, 1, FALSE);
+			proto_tree_add_item(tree, hf_isi_common_version_minor, tvb, 3, 1, FALSE);
+			break;
+		case 0x14: /* COMM_ISA_ENTITY_NOT_REACHABLE_RESP */
+			col_set_str(pinfo->cinfo, COL_INFO, "Common Message: ISA Entity Not Reachable");
+			proto_tree_add_item(tree, hf_isi_common_related_msg_id, tvb, 2, 1, FALSE);
+			break;
+		default:
+			col_set_str(pinfo->cinfo, COL_INFO, "Common Message");
+			break;
+	}
+}
+
+/* Requests go from the client object to the server object, responses
+ * back. Both map to the same key. */
+static guint32 isi_transaction_key(guint8 resource, guint8 client, guint8 server, guint8 id) {
+	return (resource << 24) | (client << 16) | (server << 8) | id;
+}
+
+static void isi_match_transaction(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, isi_msg_data_t *md, const guint8 *hdr, guint8 resource, guint8 kind, guint8 msg_id) {
+	isi_transaction_t *trans;
+	proto_item *ti;
+	nstime_t delta;
+	guint8 robj = hdr[5];
+	guint8 sobj = hdr[6];
+	guint8 id = hdr[7];
+
+	if(!pinfo->fd->flags.visited) {
+		if(kind == ISI_MSG_REQUEST) {
+			trans = se_new0(isi_transaction_t);
+			trans->req_frame = pinfo->fd->num;
+			trans->req_time = pinfo->fd->abs_ts;
+			g_hash_table_insert(isi_transactions, GUINT_TO_POINTER(isi_transaction_key(resource, sobj, robj, id)), trans);
+		} else {
+			trans = g_hash_table_lookup(isi_transactions, GUINT_TO_POINTER(isi_transaction_key(resource, robj, sobj, id)));
+			if(!trans || trans->resp_frame)
+				return;
+			trans->resp_frame = pinfo->fd->num;
+		}
+
+		md->trans = trans;
+	}
+
+	trans = md->trans;
+	if(!trans)
+		return;
+
+	/* only known once the first pass is complete, the expert info is
+	 * also wanted without a tree (tshark -2 -z expert) */
+	if(kind == ISI_MSG_REQUEST && !trans->resp_frame && pinfo->fd->flags.visited) {
+		ti = proto_tree_add_item(tree, hf_isi_no_response, tvb, 0, 0, FALSE);
+		PROTO_ITEM_SET_GENERATED(ti);
+		isi_expert_add(pinfo, ti, PI_SEQUENCE, PI_NOTE, resource, msg_id, 0, "Request without response");
+		return;
+	}
+
+	if(!tree)
+		return;
+
+	if(kind == ISI_MSG_REQUEST) {
+		if(trans->resp_frame) {
+			ti = proto_tree_add_uint(tree, hf_isi_response_in, tvb, 0, 0, trans->resp_frame);
+			PROTO_ITEM_SET_GENERATED(ti);
+		}
+	} else {
+		ti = proto_tree_add_uint(tree, hf_isi_request_in, tvb, 0, 0, trans->req_frame);
+		PROTO_ITEM_SET_GENERATED(ti);
+
+		nstime_delta(&delta, &pinfo->fd->abs_ts, &trans->req_time);
+		ti = proto_tree_add_time(tree, hf_isi_time, tvb, 0, 0, &delta);
+		PROTO_ITEM_SET_GENERATED(ti);
+	}
+}
+
+/* Conversations are between two (device, object) endpoints, in either
+ * direction. Indexes are handed out in order of the first message. */
+static guint32 isi_conversation_index(const guint8 *hdr) {
+	guint32 a = (hdr[1] << 8) | hdr[6];
+	guint32 b = (hdr[0] << 8) | hdr[5];
+	guint32 key = a < b ? (a << 16) | b : (b << 16) | a;
+	gpointer idx;
+
+	idx = g_hash_table_lookup(isi_conversations, GUINT_TO_POINTER(key));
+	if(!idx) {
+		idx = GUINT_TO_POINTER(++isi_conversation_count);
+		g_hash_table_insert(isi_conversations, GUINT_TO_POINTER(key), idx);
+	}
+
+	return GPOINTER_TO_UINT(idx) - 1;
+}
+
+/* Content length of the message at offset, capped at the captured data.
+ * broken is set when the Phonet length does not fit, lost when it is too
+ * short to find the next message. */
+static guint16 isi_message_length(tvbuff_t *tvb, gint offset, gboolean *broken, gboolean *lost) {
+	guint16 msglen = tvb_get_ntohs(tvb, offset+3);
+	guint avail = tvb_length_remaining(tvb, offset) - 8;
+
+	/* the length covers objects and transaction id at least */
+	if(msglen < 3) {
+		*broken = TRUE;
+		*lost = TRUE;
+		return 0;
+	}
+
+	if(avail < (guint)msglen - 3) {
+		*broken = TRUE;
+		return avail;
+	}
+
+	return msglen - 3;
+}
+
+/* Dissect one message at the start of tvb */
+static void dissect_isi_message(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree) {
 	proto_tree *isi_tree = NULL;
-	guint position = 0;
 	proto_item *item = NULL;
+	proto_tree *payload_tree = NULL;
+	proto_item *payload = NULL;
 	tvbuff_t *content = NULL;
+	const guint8 *hdr;
+	isi_resource_t *res;
+	isi_msg_dissector_t dissector;
+	isi_msg_data_t *md;
 
 	guint8 src = 0;
 	guint8 dst = 0;
 	guint8 resource = 0;
+	guint16 msglen = 0;
 	guint16 length = 0;
+	gboolean broken = FALSE;
+	gboolean lost = FALSE;
 
-	if(check_col(pinfo->cinfo, COL_PROTOCOL)) 
-		col_set_str(pinfo->cinfo, COL_PROTOCOL, "ISI");
-	
-	if(check_col(pinfo->cinfo,COL_INFO))
-		col_clear(pinfo->cinfo,COL_INFO);
+	/* Common Phonet/ISI Header, read only once for both passes */
+	hdr = tvb_get_ptr(tvb, 0, 8);
+	dst = hdr[0];
+	src = hdr[1];
+	resource = hdr[2];
+	msglen = pntohs(hdr+3);
+	length = isi_message_length(tvb, 0, &broken, &lost);
 
-	if(tree) {
-		/* If tree != NULL, we're doing a detailed dissection of the
-		 * packet, so we need to construct a tree. */
+	col_set_str(pinfo->cinfo, COL_DEF_SRC, val_to_str_const(src, hf_isi_device, "Unknown"));
+	col_set_str(pinfo->cinfo, COL_DEF_DST, val_to_str_const(dst, hf_isi_device, "Unknown"));
+
+	content = tvb_new_subset(tvb, 8, length, length);
 
+	if(tree) {
 		/* Start with a top-level item to add everything else to */
-		item = proto_tree_add_item(tree, proto_isi, tvb, position, -1, FALSE);
+		item = proto_tree_add_item(tree, proto_isi, tvb, 0, 8 + length, FALSE);
 		isi_tree = proto_item_add_subtree(item, ett_isi);
 
-		/* Common Phonet/ISI Header */
 		proto_tree_add_item(isi_tree, hf_isi_rdev, tvb, 0, 1, FALSE);
 		proto_tree_add_item(isi_tree, hf_isi_sdev, tvb, 1, 1, FALSE);
 		proto_tree_add_item(isi_tree, hf_isi_res,  tvb, 2, 1, FALSE);
@@ -210,24 +1220,172 @@ static void dissect_isi(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree) {
 		proto_tree_add_item(isi_tree, hf_isi_robj, tvb, 5, 1, FALSE);
 		proto_tree_add_item(isi_tree, hf_isi_sobj, tvb, 6, 1, FALSE);
 		proto_tree_add_item(isi_tree, hf_isi_id,   tvb, 7, 1, FALSE);
+	}
+
+	if(broken)
+		isi_expert_add(pinfo, item, PI_PROTOCOL, PI_WARN, resource, 0, 0, "Broken Length (%d > %d)", msglen - 3, length);
+
+	res = isi_resources[resource];
+
+	md = isi_find_frame_data(pinfo, ISI_FD_MSG, tvb_raw_offset(tvb));
+	if(!md) {
+		md = se_new0(isi_msg_data_t);
+		md->conv = isi_conversation_index(hdr);
 
-		length = tvb_get_ntohs(tvb, 3) - 3;
-		resource = tvb_get_guint8(tvb, 2);
-		dst = tvb_get_guint8(tvb, 0);
-		src = tvb_get_guint8(tvb, 1);
+		/* COMM_ISI_VERSION_GET_RESP, every message keeps the version in
+		 * effect when it was sent */
+		if(length >= 4 && tvb_get_guint8(content, 0) == ISI_COMMON_MESSAGE && tvb_get_guint8(content, 1) == 0x13)
+			isi_versions[resource] = (tvb_get_guint8(content, 2) << 8) | tvb_get_guint8(content, 3);
+		md->version = isi_versions[resource];
+		isi_add_kind_data(pinfo, ISI_FD_MSG, tvb_raw_offset(tvb), md);
+	}
+
+	if(tree) {
+		proto_item *ti = proto_tree_add_uint(isi_tree, hf_isi_conv, tvb, 0, 0, md->conv);
+		PROTO_ITEM_SET_GENERATED(ti);
 
-		if(tvb->length - 8 < length) {
-			expert_add_info_format(pinfo, item, PI_PROTOCOL, PI_WARN, "Broken Length (%d > %d)", length, tvb->length-8);
-			length = tvb->length - 8;
+		if(md->version) {
+			ti = proto_tree_add_string(isi_tree, hf_isi_version, tvb, 0, 0,
+				ep_strdup_printf("%u.%u", md->version >> 8, md->version & 0xFF));
+			PROTO_ITEM_SET_GENERATED(ti);
 		}
+	}
+
+	/* Link requests and responses before the payload is decoded, so a
+	 * failing message dissector does not lose the match */
+	if(res && length) {
+		guint8 msg_id = tvb_get_guint8(content, 0);
 
-		col_set_str(pinfo->cinfo, COL_DEF_SRC, val_to_str_const(src, hf_isi_device, "Unknown"));
-		col_set_str(pinfo->cinfo, COL_DEF_DST, val_to_str_const(dst, hf_isi_device, "Unknown"));
+		if(res->kind[msg_id])
+			isi_match_transaction(tvb, pinfo, isi_tree, md, hdr, resource, res->kind[msg_id], msg_id);
+	}
+
+	if(have_tap_listener(isi_tap)) {
+		isi_tap_info_t *info = ep_alloc0(sizeof(isi_tap_info_t));
 
-		content = tvb_new_subset(tvb, 8, length, length);
+		info->rdev = dst;
+		info->sdev = src;
+		info->resource = resource;
+		info->robj = hdr[5];
+		info->sobj = hdr[6];
+		info->id = hdr[7];
+		info->has_msg_id = length > 0;
+		info->msg_id = length ? tvb_get_guint8(content, 0) : 0;
+		info->len = 8 + length;
+		info->conv = md->conv;
+		info->version = md->version;
 
-		/* Call subdissector depending on the resource ID */
-		if(!dissector_try_port(isi_resource_dissector_table, resource, content, pinfo, isi_tree))
+		if(md->trans && res->kind[info->msg_id] == ISI_MSG_RESPONSE) {
+			info->request_in = md->trans->req_frame;
+			nstime_delta(&info->response_time, &pinfo->fd->abs_ts, &md->trans->req_time);
+		}
+		if(md->trans && res->kind[info->msg_id] == ISI_MSG_REQUEST && pinfo->fd->flags.visited)
+			info->no_response = !md->trans->resp_frame;
+
+		tap_queue_packet(isi_tap, pinfo, info);
+	}
+
+	/* Common messages look the same on every resource and are decoded
+	 * before the resource dispatch */
+	if(length >= 2 && tvb_get_guint8(content, 0) == ISI_COMMON_MESSAGE && (!res || res->depth != ISI_DEPTH_HEADER)) {
+		if(tree && res && res->hf_msg_id)
+			proto_tree_add_item(isi_tree, *res->hf_msg_id, content, 0, 1, FALSE);
+
+		if(tree && (!res || res->depth == ISI_DEPTH_FULL)) {
+			payload = proto_tree_add_text(isi_tree, content, 0, -1, "Payload");
+			payload_tree = proto_item_add_subtree(payload, ett_isi_msg);
+		}
+
+		dissect_isi_common(content, pinfo, payload, payload_tree);
+		return;
+	}
+
+	/* Resources without a message registry may still be handled by
+	 * a dissector registered in the isi.resource table */
+	if(!res || !length || res->depth == ISI_DEPTH_HEADER) {
+		col_set_str(pinfo->cinfo, COL_INFO, val_to_str_ext_const(resource, &hf_isi_resource_ext, "Unknown resource"));
+
+		if(tree && (!res || !length) && !dissector_try_port(isi_resource_dissector_table, resource, content, pinfo, isi_tree))
+			call_dissector(data_handle, content, pinfo, isi_tree);
+		return;
+	}
+
+	dissector = res->msg[tvb_get_guint8(content, 0)];
+	if(!dissector)
+		dissector = res->unknown;
+
+	if(!dissector) {
+		col_set_str(pinfo->cinfo, COL_INFO, val_to_str_ext_const(resource, &hf_isi_resource_ext, "Unknown resource"));
+		if(tree)
 			call_dissector(data_handle, content, pinfo, isi_tree);
+		return;
+	}
+
+	/* Summary depth only adds the message ID next to the header */
+	if(res->depth == ISI_DEPTH_SUMMARY) {
+		if(tree && res->hf_msg_id)
+			proto_tree_add_item(isi_tree, *res->hf_msg_id, content, 0, 1, FALSE);
+		dissector(content, pinfo, NULL, NULL);
+		return;
+	}
+
+	if(tree) {
+		payload = proto_tree_add_text(isi_tree, content, 0, -1, "Payload");
+		payload_tree = proto_item_add_subtree(payload, ett_isi_msg);
+		if(res->hf_msg_id)
+			proto_tree_add_item(payload_tree, *res->hf_msg_id, content, 0, 1, FALSE);
 	}
+
+	/* Without a tree (tshark column pass, packet list) the message
+	 * dissector only fills the info column */
+	dissector(content, pinfo, payload, payload_tree);
+}
+
+/* Dissect all messages packed into tvb, count is the number of
+ * messages already dissected in this frame */
+static void dissect_isi_messages(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, guint *count) {
+	gint offset = 0;
+	gboolean broken = FALSE;
+	gboolean lost = FALSE;
+	guint16 length;
+
+	while(!lost && tvb_length_remaining(tvb, offset) >= 8) {
+		/* taken from the header, so a message whose dissector fails
+		 * does not take the following ones with it */
+		length = isi_message_length(tvb, offset, &broken, &lost);
+
+		isi_col_next_message(pinfo, count);
+		TRY {
+			dissect_isi_message(tvb_new_subset_remaining(tvb, offset), pinfo, tree);
+		}
+		CATCH2(BoundsError, ReportedBoundsError) {
+			show_exception(tvb_new_subset(tvb, offset, 8 + length, 8 + length), pinfo, tree, EXCEPT_CODE, GET_MESSAGE);
+		}
+		ENDTRY;
+
+		offset += 8 + length;
+	}
+
+	if(lost && tvb_length_remaining(tvb, offset) > 0) {
+		proto_item *item = proto_tree_add_text(tree, tvb, offset, -1, "Malformed trailing bytes");
+		isi_expert_add(pinfo, item, PI_MALFORMED, PI_ERROR, 0, 0, 0, "%d bytes after a message with a broken length", tvb_length_remaining(tvb, offset));
+	} else if(tvb_length_remaining(tvb, offset) > 0) {
+		proto_item *item = proto_tree_add_text(tree, tvb, offset, -1, "Trailing bytes");
+		isi_expert_add(pinfo, item, PI_MALFORMED, PI_WARN, 0, 0, 0, "%d trailing bytes after the last message", tvb_length_remaining(tvb, offset));
+	}
+}
+
+/* The dissector itself */
+static void dissect_isi(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree) {
+	guint count = 0;
+
+	isi_frame_source = 0;
+
+	if(check_col(pinfo->cinfo, COL_PROTOCOL)) 
+		col_set_str(pinfo->cinfo, COL_PROTOCOL, "ISI");
+	
+	if(check_col(pinfo->cinfo,COL_INFO))
+		col_clear(pinfo->cinfo,COL_INFO);
+
+	dissect_isi_messages(tvb, pinfo, tree, &count);
 }
@@ -8,5 +8,97 @@ extern int proto_isi;
 extern guint32 ett_isi_msg;
 extern guint32 ett_isi_network_gsm_band_info;
 
+/* Dissector for a single ISI message. It always fills the info column,
+ * item and tree are NULL when no tree is built (tshark column pass). */
+typedef void (*isi_msg_dissector_t)(tvbuff_t *tvb, packet_info *pinfo, proto_item *item, proto_tree *tree);
+
+/* Resource/message dispatch registry, usable from other plugins as well.
+ * unknown is called for message IDs without a registered dissector. */
+void isi_register_resource(guint8 resource, guint32 *hf_msg_id, isi_msg_dissector_t unknown);
+void isi_register_message(guint8 resource, guint8 msg_id, isi_msg_dissector_t dissector);
+
+/* Pair a request with its response, so the two are linked in the tree
+ * together with the response time. Several responses may share one
+ * request ID (e.g. a success and a failure response). */
+void isi_register_transaction(guint8 resource, guint8 req_id, guint8 resp_id);
+
+/* For message dissectors: if the message with content tvb is a matched
+ * response, returns TRUE with the request frame and the response time */
+gboolean isi_get_response(packet_info *pinfo, tvbuff_t *tvb, guint32 *request_in, nstime_t *time);
+
+/* Names of resources and of the message IDs registered for them, for
+ * taps and statistics */
+const gchar *isi_resource_name(guint8 resource);
+const gchar *isi_message_name(guint8 resource, guint8 msg_id);
+
+/* Known Phonet devices */
+#define ISI_DEV_MODEM 0x00
+#define ISI_DEV_HOST  0x6c
+
+/* Data of the "isi" tap, queued for every message */
+typedef struct _isi_tap_info_t {
+	guint8 rdev;
+	guint8 sdev;
+	guint8 resource;
+	guint8 robj;
+	guint8 sobj;
+	guint8 id;
+	gboolean has_msg_id;
+	guint8 msg_id;
+	guint16 len;		/* header included */
+	guint32 conv;		/* conversation index, as in isi.conv */
+	guint16 version;	/* ISI version of the resource (major << 8 | minor), 0 if unknown */
+	guint32 request_in;	/* responses: frame of the matched request, else 0 */
+	nstime_t response_time;	/* responses: time since the request, as in isi.time */
+	gboolean no_response;	/* requests: unanswered, on a second pass (tshark -2) only */
+} isi_tap_info_t;
+
+/* Expert info grouped per (resource, message, subblock) key, group,
+ * severity and format string. Only the first frames of each key are
+ * listed, the next one carries a summary with the count and frame range
+ * of all occurrences. Frames are only counted when the call is made:
+ * resource dissectors check most problems while building the tree, so
+ * a pass without a tree (tshark without -V or -2) does not count them. */
+void isi_expert_add(packet_info *pinfo, proto_item *item, int group, int severity, guint8 resource, guint8 msg_id, guint8 subblock, const char *format, ...) G_GNUC_PRINTF(8, 9);
+
+/* Per-frame cache for parsed message layouts, so that re-dissection
+ * (GUI clicks, refilters) only has to emit tree items. Entries are keyed
+ * by the raw offset of the content tvb and by the reassembled message it
+ * belongs to, and must be se_alloc'ed. One entry per message content. */
+gpointer isi_get_frame_data(packet_info *pinfo, tvbuff_t *tvb);
+void isi_add_frame_data(packet_info *pinfo, tvbuff_t *tvb, gpointer data);
+
+/* Decode len UCS-2/UTF-16BE characters at offset into a packet scope
+ * (ep_alloc'ed) UTF-8 string. A NUL character ends the string. */
+const char *isi_ucs2_to_utf8(tvbuff_t *tvb, gint offset, guint len);
+
+/* Like isi_ucs2_to_utf8(), but strings are decoded once per capture and
+ * shared between all frames carrying the same bytes. For the few strings
+ * that repeat all the time (operator and provider names). */
+const char *isi_ucs2_intern(tvbuff_t *tvb, gint offset, guint len);
+
+/* Iterator over a chain of count subblocks starting at offset. Every
+ * block starts with a hdr_len byte header holding its type and its
+ * length (header included) at type_offset and len_offset. Lengths are
+ * checked against the remaining bytes, so the iterator never reads past
+ * the tvb and always moves forward. It stops with malformed set and
+ * offset pointing to the broken block. */
+typedef struct _isi_subblock_iter_t {
+	tvbuff_t *tvb;
+	guint offset;
+	guint count;
+	guint8 hdr_len;
+	guint8 type_offset;
+	guint8 len_offset;
+	gboolean malformed;
+
+	/* current block */
+	guint block_offset;
+	guint8 type;
+	guint8 len;
+} isi_subblock_iter_t;
+
+void isi_subblock_iter_init(isi_subblock_iter_t *it, tvbuff_t *tvb, guint offset, guint count, guint8 hdr_len, guint8 type_offset, guint8 len_offset);
+gboolean isi_subblock_iter_next(isi_subblock_iter_t *it);
 
 #endif
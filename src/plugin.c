@@ -5,6 +5,16 @@ G_MODULE_EXPORT const gchar version[] = "0.0.1";
 
 extern void proto_register_isi(void);
 extern void proto_reg_handoff_isi(void);
+extern void register_tap_listener_isi_stat(void);
+extern void register_tap_listener_isi_conv(void);
+extern void register_tap_listener_isi_boot(void);
+extern void register_tap_listener_isi_sms(void);
+extern void register_tap_listener_isi_network(void);
+extern void register_tap_listener_isi_rssi(void);
+extern void register_tap_listener_isi_gps(void);
+extern void register_tap_listener_isi_track(void);
+extern void register_tap_listener_isi_coverage(void);
+extern void register_tap_listener_isi_sats(void);
 
 G_MODULE_EXPORT void plugin_register (void) {
 	proto_register_isi();
@@ -13,4 +23,17 @@ G_MODULE_EXPORT void plugin_register (void) {
 G_MODULE_EXPORT void plugin_reg_handoff(void) {
 	proto_reg_handoff_isi();
 }
+
+G_MODULE_EXPORT void plugin_register_tap_listener(void) {
+	register_tap_listener_isi_stat();
+	register_tap_listener_isi_conv();
+	register_tap_listener_isi_boot();
+	register_tap_listener_isi_sms();
+	register_tap_listener_isi_network();
+	register_tap_listener_isi_rssi();
+	register_tap_listener_isi_gps();
+	register_tap_listener_isi_track();
+	register_tap_listener_isi_coverage();
+	register_tap_listener_isi_sats();
+}
 #endif
@@ -0,0 +1,420 @@
+/* tap-isi-boot.c
+ * tshark -z isi,boot[,csv][,filter] - modem boot critical path
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+#include <epan/packet.h>
+#include <epan/tap.h>
+#include <epan/stat_cmd_args.h>
+
+#include "packet-isi.h"
+#include "isi-network.h"
+
+/* Boot steps from the first ISI message (power-on) up to network
+ * registration. Steps are either an indication or a request, which is
+ * done with its matched response. deps lists the steps that have to be
+ * done before a step can start. Registration comes from the isi.network
+ * tap, it starts with the first registration status and is done with the
+ * first HOME or ROAM status. */
+enum {
+	ISI_BOOT_SIM_READY,
+	ISI_BOOT_SIM_AUTH,
+	ISI_BOOT_SIM_IMSI,
+	ISI_BOOT_SIM_NETWORK_INFO,
+	ISI_BOOT_GSS_RAT,
+	ISI_BOOT_NET_REG,
+	ISI_BOOT_STEPS
+};
+
+#define ISI_BOOT_DEP(step) (1 << (step))
+
+static const struct {
+	const char *name;	/* also the CSV column */
+	guint8 resource;
+	guint8 msg_id;
+	gboolean request;
+	guint deps;
+} isi_boot_steps[ISI_BOOT_STEPS] = {
+	{"sim_auth_status_ind", 0x08, 0x10, FALSE, 0},
+	{"sim_auth_req", 0x08, 0x07, TRUE, ISI_BOOT_DEP(ISI_BOOT_SIM_READY)},
+	{"sim_imsi", 0x09, 0x1D, TRUE, ISI_BOOT_DEP(ISI_BOOT_SIM_AUTH)},
+	{"sim_network_info", 0x09, 0x19, TRUE, ISI_BOOT_DEP(ISI_BOOT_SIM_AUTH)},
+	{"gss_rat", 0x32, 0x00, TRUE, 0},
+	{"net_registered", 0x0A, 0xE2, FALSE,
+		ISI_BOOT_DEP(ISI_BOOT_SIM_IMSI) | ISI_BOOT_DEP(ISI_BOOT_SIM_NETWORK_INFO) | ISI_BOOT_DEP(ISI_BOOT_GSS_RAT)}
+};
+
+/* Number of slowest responses listed */
+#define ISI_BOOT_SLOWEST 10
+
+typedef struct _isi_boot_step_t {
+	gboolean started;
+	gboolean done;
+	guint32 frame;		/* request or indication */
+	nstime_t start;
+	nstime_t end;
+} isi_boot_step_t;
+
+typedef struct _isi_boot_response_t {
+	guint32 frame;
+	guint32 request_in;
+	guint8 resource;
+	guint8 msg_id;
+	nstime_t time;
+} isi_boot_response_t;
+
+typedef struct _isi_boot_t {
+	char *filter;
+	gboolean csv;
+	gboolean seen;
+	nstime_t power_on;	/* first ISI message */
+	isi_boot_step_t step[ISI_BOOT_STEPS];
+	/* slowest first */
+	isi_boot_response_t slowest[ISI_BOOT_SLOWEST];
+	guint slowest_count;
+} isi_boot_t;
+
+static void isi_boot_reset(void *tapdata) {
+	isi_boot_t *boot = tapdata;
+
+	boot->seen = FALSE;
+	memset(boot->step, 0, sizeof(boot->step));
+	boot->slowest_count = 0;
+}
+
+static gint isi_boot_time_cmp(const nstime_t *a, const nstime_t *b) {
+	if(a->secs != b->secs)
+		return a->secs < b->secs ? -1 : 1;
+	if(a->nsecs != b->nsecs)
+		return a->nsecs < b->nsecs ? -1 : 1;
+	return 0;
+}
+
+static void isi_boot_add_response(isi_boot_t *boot, packet_info *pinfo, const isi_tap_info_t *info) {
+	guint i;
+
+	for(i = boot->slowest_count; i > 0; i--)
+		if(isi_boot_time_cmp(&boot->slowest[i - 1].time, &info->response_time) >= 0)
+			break;
+
+	if(i == ISI_BOOT_SLOWEST)
+		return;
+
+	if(boot->slowest_count < ISI_BOOT_SLOWEST)
+		boot->slowest_count++;
+	memmove(&boot->slowest[i + 1], &boot->slowest[i], (boot->slowest_count - i - 1) * sizeof(isi_boot_response_t));
+
+	boot->slowest[i].frame = pinfo->fd->num;
+	boot->slowest[i].request_in = info->request_in;
+	boot->slowest[i].resource = info->resource;
+	boot->slowest[i].msg_id = info->msg_id;
+	boot->slowest[i].time = info->response_time;
+}
+
+static gboolean isi_boot_resource(guint8 resource) {
+	guint i;
+
+	for(i = 0; i < ISI_BOOT_STEPS; i++)
+		if(isi_boot_steps[i].resource == resource)
+			return TRUE;
+
+	return FALSE;
+}
+
+static int isi_boot_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt, const void *data) {
+	isi_boot_t *boot = tapdata;
+	const isi_tap_info_t *info = data;
+	isi_boot_step_t *st;
+	guint i;
+
+	if(!boot->seen) {
+		boot->power_on = pinfo->fd->abs_ts;
+		boot->seen = TRUE;
+	}
+
+	/* the boot is over once the modem is registered */
+	if(boot->step[ISI_BOOT_NET_REG].done || !info->has_msg_id)
+		return 0;
+
+	for(i = 0; i < ISI_BOOT_STEPS; i++) {
+		st = &boot->step[i];
+
+		/* see isi_boot_net_packet() */
+		if(i == ISI_BOOT_NET_REG)
+			continue;
+
+		if(!st->started && info->resource == isi_boot_steps[i].resource && info->msg_id == isi_boot_steps[i].msg_id) {
+			st->started = TRUE;
+			st->frame = pinfo->fd->num;
+			st->start = pinfo->fd->abs_ts;
+
+			if(!isi_boot_steps[i].request) {
+				st->done = TRUE;
+				st->end = pinfo->fd->abs_ts;
+			}
+		} else if(st->started && !st->done && info->request_in == st->frame) {
+			st->done = TRUE;
+			st->end = pinfo->fd->abs_ts;
+		}
+	}
+
+	if(info->request_in && isi_boot_resource(info->resource))
+		isi_boot_add_response(boot, pinfo, info);
+
+	return 1;
+}
+
+/* The status indications during boot usually report searching first,
+ * only a registered status finishes the boot */
+static int isi_boot_net_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt, const void *data) {
+	isi_boot_t *boot = tapdata;
+	const isi_network_tap_info_t *info = data;
+	isi_boot_step_t *st = &boot->step[ISI_BOOT_NET_REG];
+
+	if(st->done || !info->has_reg)
+		return 0;
+
+	if(!st->started) {
+		st->started = TRUE;
+		st->frame = pinfo->fd->num;
+		st->start = pinfo->fd->abs_ts;
+	}
+
+	switch(info->reg_status) {
+		case ISI_NETWORK_REG_HOME:
+		case ISI_NETWORK_REG_ROAM:
+		case ISI_NETWORK_REG_ROAM_BLINK:
+			st->done = TRUE;
+			st->end = pinfo->fd->abs_ts;
+			break;
+	}
+
+	return 1;
+}
+
+/* Steps this step waited for. Steps that were not seen (e.g. no PIN
+ * query) are replaced by their own dependencies. */
+static guint isi_boot_effective_deps(const isi_boot_t *boot, guint step) {
+	guint deps = 0;
+	guint i;
+
+	for(i = 0; i < ISI_BOOT_STEPS; i++) {
+		if(!(isi_boot_steps[step].deps & ISI_BOOT_DEP(i)))
+			continue;
+
+		if(boot->step[i].done)
+			deps |= ISI_BOOT_DEP(i);
+		else
+			deps |= isi_boot_effective_deps(boot, i);
+	}
+
+	return deps;
+}
+
+/* The dependency that was done last, i.e. the one the step was
+ * actually waiting for, or -1 for power-on */
+static gint isi_boot_predecessor(const isi_boot_t *boot, guint step) {
+	guint deps = isi_boot_effective_deps(boot, step);
+	gint pred = -1;
+	guint i;
+
+	for(i = 0; i < ISI_BOOT_STEPS; i++)
+		if((deps & ISI_BOOT_DEP(i)) && (pred < 0 || isi_boot_time_cmp(&boot->step[i].end, &boot->step[pred].end) > 0))
+			pred = i;
+
+	return pred;
+}
+
+/* Last step of the critical path: registration, or the last step that
+ * was done if the capture ends before */
+static gint isi_boot_last_step(const isi_boot_t *boot) {
+	gint last = -1;
+	guint i;
+
+	if(boot->step[ISI_BOOT_NET_REG].done)
+		return ISI_BOOT_NET_REG;
+
+	for(i = 0; i < ISI_BOOT_STEPS; i++)
+		if(boot->step[i].done && (last < 0 || isi_boot_time_cmp(&boot->step[i].end, &boot->step[last].end) > 0))
+			last = i;
+
+	return last;
+}
+
+/* Critical path in boot order, returns its length */
+static guint isi_boot_critical_path(const isi_boot_t *boot, gint path[ISI_BOOT_STEPS]) {
+	gint rev[ISI_BOOT_STEPS];
+	gint step = isi_boot_last_step(boot);
+	guint len = 0;
+	guint i;
+
+	for(; step >= 0; step = isi_boot_predecessor(boot, step))
+		rev[len++] = step;
+
+	for(i = 0; i < len; i++)
+		path[i] = rev[len - i - 1];
+
+	return len;
+}
+
+static gdouble isi_boot_delta(const nstime_t *end, const nstime_t *start) {
+	nstime_t delta;
+
+	nstime_delta(&delta, end, start);
+	return nstime_to_sec(&delta);
+}
+
+static void isi_boot_draw_csv(const isi_boot_t *boot, const gint *path, guint len) {
+	guint i;
+
+	printf("# total");
+	for(i = 0; i < ISI_BOOT_STEPS; i++)
+		printf(",%s", isi_boot_steps[i].name);
+	printf(",critical_path\n");
+
+	if(boot->step[ISI_BOOT_NET_REG].done)
+		printf("%.6f", isi_boot_delta(&boot->step[ISI_BOOT_NET_REG].end, &boot->power_on));
+
+	for(i = 0; i < ISI_BOOT_STEPS; i++) {
+		printf(",");
+		if(boot->step[i].done)
+			printf("%.6f", isi_boot_delta(&boot->step[i].end, &boot->power_on));
+	}
+
+	printf(",");
+	for(i = 0; i < len; i++)
+		printf("%s%s", i ? ">" : "", isi_boot_steps[path[i]].name);
+	printf("\n");
+}
+
+static void isi_boot_draw(void *tapdata) {
+	isi_boot_t *boot = tapdata;
+	const isi_boot_step_t *st;
+	const isi_boot_response_t *r;
+	gint path[ISI_BOOT_STEPS];
+	nstime_t pred_end;
+	guint len, i;
+	gint pred;
+
+	len = isi_boot_critical_path(boot, path);
+
+	if(boot->csv) {
+		isi_boot_draw_csv(boot, path, len);
+		return;
+	}
+
+	printf("\n");
+	printf("=========================================================================================\n");
+	printf("ISI Boot Critical Path\n");
+	printf("Filter: %s\n", boot->filter ? boot->filter : "<none>");
+
+	if(!boot->seen) {
+		printf("No ISI messages\n");
+		printf("=========================================================================================\n");
+		return;
+	}
+
+	if(boot->step[ISI_BOOT_NET_REG].done)
+		printf("Power-on to registration: %.6f s\n", isi_boot_delta(&boot->step[ISI_BOOT_NET_REG].end, &boot->power_on));
+	else
+		printf("Power-on to registration: not registered in this capture\n");
+
+	printf("\nSteps (times relative to the first ISI message)\n");
+	printf("%-20s %8s %12s %12s %12s\n", "Step", "Frame", "Start", "Done", "Response");
+	for(i = 0; i < ISI_BOOT_STEPS; i++) {
+		st = &boot->step[i];
+
+		if(!st->started) {
+			printf("%-20s %8s\n", isi_boot_steps[i].name, "-");
+			continue;
+		}
+
+		printf("%-20s %8u %12.6f", isi_boot_steps[i].name, st->frame, isi_boot_delta(&st->start, &boot->power_on));
+		if(!st->done)
+			printf(" %12s\n", i == ISI_BOOT_NET_REG ? "searching" : "no response");
+		else if(isi_boot_steps[i].request)
+			printf(" %12.6f %12.6f\n", isi_boot_delta(&st->end, &boot->power_on), isi_boot_delta(&st->end, &st->start));
+		else
+			printf(" %12.6f %12s\n", isi_boot_delta(&st->end, &boot->power_on), "-");
+	}
+
+	/* waiting is the gap between the step the path came from being
+	 * done and this step starting */
+	printf("\nCritical path\n");
+	printf("%-20s %-20s %12s %12s\n", "Step", "Waited for", "Waiting", "Response");
+	for(i = 0; i < len; i++) {
+		st = &boot->step[path[i]];
+		pred = i ? path[i - 1] : -1;
+		pred_end = pred < 0 ? boot->power_on : boot->step[pred].end;
+
+		printf("%-20s %-20s %12.6f", isi_boot_steps[path[i]].name, pred < 0 ? "power-on" : isi_boot_steps[pred].name,
+			isi_boot_delta(&st->start, &pred_end));
+		if(isi_boot_steps[path[i]].request)
+			printf(" %12.6f\n", isi_boot_delta(&st->end, &st->start));
+		else
+			printf(" %12s\n", "-");
+	}
+
+	printf("\nSlowest responses during boot\n");
+	printf("%-20s %-32s %8s %8s %12s\n", "Resource", "Response", "Frame", "Request", "Time");
+	for(i = 0; i < boot->slowest_count; i++) {
+		r = &boot->slowest[i];
+		printf("%-20s %-32s %8u %8u %12.6f\n", isi_resource_name(r->resource), isi_message_name(r->resource, r->msg_id),
+			r->frame, r->request_in, nstime_to_sec(&r->time));
+	}
+
+	printf("=========================================================================================\n");
+}
+
+static void isi_boot_init(const char *optarg, void *userdata) {
+	isi_boot_t *boot;
+	const char *args = NULL;
+	GString *error;
+
+	boot = g_new0(isi_boot_t, 1);
+
+	if(!strncmp(optarg, "isi,boot,", 9))
+		args = optarg + 9;
+	if(args && (!strcmp(args, "csv") || !strncmp(args, "csv,", 4))) {
+		boot->csv = TRUE;
+		args = args[3] ? args + 4 : NULL;
+	}
+	if(args)
+		boot->filter = g_strdup(args);
+
+	error = register_tap_listener("isi", boot, boot->filter, TL_REQUIRES_NOTHING,
+		isi_boot_reset, isi_boot_packet, isi_boot_draw);
+	if(!error)
+		error = register_tap_listener("isi.network", boot, boot->filter, TL_REQUIRES_NOTHING,
+			NULL, isi_boot_net_packet, NULL);
+	if(error) {
+		fprintf(stderr, "tshark: Couldn't register isi,boot tap: %s\n", error->str);
+		g_string_free(error, TRUE);
+		g_free(boot->filter);
+		g_free(boot);
+		exit(1);
+	}
+}
+
+void register_tap_listener_isi_boot(void) {
+	register_stat_cmd_arg("isi,boot", isi_boot_init, NULL);
+}
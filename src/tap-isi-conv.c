@@ -0,0 +1,328 @@
+/* tap-isi-conv.c
+ * tshark -z isi,conv[,filter] and -z isi,endpoints[,filter]
+ * Phonet conversations and endpoints, keyed by (device, object)
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+#include <epan/packet.h>
+#include <epan/tap.h>
+#include <epan/stat_cmd_args.h>
+
+#include "packet-isi.h"
+
+/* Endpoints are (device << 8 | object) */
+#define ISI_EP(dev, obj) ((guint16)(((dev) << 8) | (obj)))
+
+typedef struct _isi_conv_counter_t {
+	guint32 msgs;
+	guint64 bytes;
+} isi_conv_counter_t;
+
+/* a is the lower endpoint, ab counts a -> b and ba counts b -> a */
+typedef struct _isi_conv_stat_t {
+	guint16 a;
+	guint16 b;
+	isi_conv_counter_t ab;
+	isi_conv_counter_t ba;
+	nstime_t start;
+	nstime_t last;
+} isi_conv_stat_t;
+
+typedef struct _isi_endpoint_stat_t {
+	guint16 ep;
+	isi_conv_counter_t tx;
+	isi_conv_counter_t rx;
+	nstime_t start;
+	nstime_t last;
+} isi_endpoint_stat_t;
+
+typedef struct _isi_conv_t {
+	char *filter;
+	gboolean endpoints;	/* -z isi,endpoints, else -z isi,conv */
+	/* isi_conv_stat_t by isi.conv index, msgs 0 for unused entries */
+	GArray *convs;
+	/* endpoint -> isi_endpoint_stat_t */
+	GHashTable *eps;
+} isi_conv_t;
+
+static const char *isi_conv_dev_name(guint8 dev) {
+	switch(dev) {
+		case ISI_DEV_HOST:
+			return "Host";
+		case ISI_DEV_MODEM:
+			return "Modem";
+		default:
+			return NULL;
+	}
+}
+
+/* "Host/0x10", returned string is g_malloc'ed */
+static char *isi_conv_ep_str(guint16 ep) {
+	const char *dev = isi_conv_dev_name(ep >> 8);
+
+	if(dev)
+		return g_strdup_printf("%s/0x%02x", dev, ep & 0xff);
+	return g_strdup_printf("0x%02x/0x%02x", ep >> 8, ep & 0xff);
+}
+
+static gdouble isi_conv_duration(const nstime_t *start, const nstime_t *last) {
+	nstime_t delta;
+
+	nstime_delta(&delta, last, start);
+	return nstime_to_sec(&delta);
+}
+
+static void isi_conv_count(isi_conv_counter_t *cnt, guint len) {
+	cnt->msgs++;
+	cnt->bytes += len;
+}
+
+static void isi_conv_reset(void *tapdata) {
+	isi_conv_t *tap = tapdata;
+
+	g_array_set_size(tap->convs, 0);
+	g_hash_table_remove_all(tap->eps);
+}
+
+static isi_endpoint_stat_t *isi_conv_get_endpoint(isi_conv_t *tap, guint16 ep, packet_info *pinfo) {
+	isi_endpoint_stat_t *st = g_hash_table_lookup(tap->eps, GUINT_TO_POINTER(ep));
+
+	if(!st) {
+		st = g_new0(isi_endpoint_stat_t, 1);
+		st->ep = ep;
+		st->start = pinfo->fd->rel_ts;
+		g_hash_table_insert(tap->eps, GUINT_TO_POINTER(ep), st);
+	}
+	st->last = pinfo->fd->rel_ts;
+
+	return st;
+}
+
+static int isi_conv_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt, const void *data) {
+	isi_conv_t *tap = tapdata;
+	const isi_tap_info_t *info = data;
+	guint16 src = ISI_EP(info->sdev, info->sobj);
+	guint16 dst = ISI_EP(info->rdev, info->robj);
+	isi_conv_stat_t *conv;
+
+	/* the dissector hands out conversation indexes densely */
+	if(info->conv >= tap->convs->len)
+		g_array_set_size(tap->convs, info->conv + 1);
+
+	conv = &g_array_index(tap->convs, isi_conv_stat_t, info->conv);
+	if(!conv->ab.msgs && !conv->ba.msgs) {
+		conv->a = MIN(src, dst);
+		conv->b = MAX(src, dst);
+		conv->start = pinfo->fd->rel_ts;
+	}
+	conv->last = pinfo->fd->rel_ts;
+	isi_conv_count(src == conv->a ? &conv->ab : &conv->ba, info->len);
+
+	isi_conv_count(&isi_conv_get_endpoint(tap, src, pinfo)->tx, info->len);
+	isi_conv_count(&isi_conv_get_endpoint(tap, dst, pinfo)->rx, info->len);
+
+	return 1;
+}
+
+/* busiest first */
+static gint isi_conv_cmp(gconstpointer a, gconstpointer b) {
+	const isi_conv_stat_t *ca = *(const isi_conv_stat_t * const *) a;
+	const isi_conv_stat_t *cb = *(const isi_conv_stat_t * const *) b;
+	guint32 ma = ca->ab.msgs + ca->ba.msgs;
+	guint32 mb = cb->ab.msgs + cb->ba.msgs;
+
+	return ma < mb ? 1 : ma > mb ? -1 : 0;
+}
+
+static gint isi_endpoint_cmp(gconstpointer a, gconstpointer b) {
+	const isi_endpoint_stat_t *ea = *(const isi_endpoint_stat_t * const *) a;
+	const isi_endpoint_stat_t *eb = *(const isi_endpoint_stat_t * const *) b;
+	guint32 ma = ea->tx.msgs + ea->rx.msgs;
+	guint32 mb = eb->tx.msgs + eb->rx.msgs;
+
+	return ma < mb ? 1 : ma > mb ? -1 : 0;
+}
+
+static gint isi_endpoint_key_cmp(gconstpointer a, gconstpointer b) {
+	const isi_endpoint_stat_t *ea = *(const isi_endpoint_stat_t * const *) a;
+	const isi_endpoint_stat_t *eb = *(const isi_endpoint_stat_t * const *) b;
+
+	return (gint) ea->ep - (gint) eb->ep;
+}
+
+static void isi_conv_collect_endpoint(gpointer key, gpointer value, gpointer user_data) {
+	g_array_append_val((GArray *) user_data, value);
+}
+
+static GArray *isi_conv_sorted_endpoints(isi_conv_t *tap, GCompareFunc cmp) {
+	GArray *eps = g_array_new(FALSE, FALSE, sizeof(isi_endpoint_stat_t *));
+
+	g_hash_table_foreach(tap->eps, isi_conv_collect_endpoint, eps);
+	g_array_sort(eps, cmp);
+
+	return eps;
+}
+
+static void isi_conv_draw_conversations(isi_conv_t *tap) {
+	GArray *convs = g_array_new(FALSE, FALSE, sizeof(isi_conv_stat_t *));
+	isi_conv_stat_t *conv;
+	char *a, *b;
+	guint i;
+
+	for(i = 0; i < tap->convs->len; i++) {
+		conv = &g_array_index(tap->convs, isi_conv_stat_t, i);
+		if(conv->ab.msgs || conv->ba.msgs)
+			g_array_append_val(convs, conv);
+	}
+	g_array_sort(convs, isi_conv_cmp);
+
+	printf("%-16s    %-16s %8s %10s %8s %10s %8s %10s %12s %10s\n", "A", "B",
+		"A->B", "Bytes", "B->A", "Bytes", "Total", "Bytes", "Rel. Start", "Duration");
+
+	for(i = 0; i < convs->len; i++) {
+		conv = g_array_index(convs, isi_conv_stat_t *, i);
+		a = isi_conv_ep_str(conv->a);
+		b = isi_conv_ep_str(conv->b);
+
+		printf("%-16s <-> %-16s %8u %10" G_GINT64_MODIFIER "u %8u %10" G_GINT64_MODIFIER "u %8u %10" G_GINT64_MODIFIER "u %12.6f %10.4f\n",
+			a, b, conv->ab.msgs, conv->ab.bytes, conv->ba.msgs, conv->ba.bytes,
+			conv->ab.msgs + conv->ba.msgs, conv->ab.bytes + conv->ba.bytes,
+			nstime_to_sec(&conv->start), isi_conv_duration(&conv->start, &conv->last));
+
+		g_free(a);
+		g_free(b);
+	}
+
+	g_array_free(convs, TRUE);
+}
+
+/* Messages sent from each endpoint (rows) to each endpoint (columns) */
+static void isi_conv_draw_matrix(isi_conv_t *tap) {
+	GArray *eps = isi_conv_sorted_endpoints(tap, isi_endpoint_key_cmp);
+	GHashTable *cells = g_hash_table_new(g_direct_hash, g_direct_equal);
+	isi_conv_stat_t *conv;
+	guint16 row, col;
+	guint i, j;
+
+	/* (sender << 16 | receiver) -> messages */
+	for(i = 0; i < tap->convs->len; i++) {
+		conv = &g_array_index(tap->convs, isi_conv_stat_t, i);
+		if(conv->ab.msgs)
+			g_hash_table_insert(cells, GUINT_TO_POINTER(conv->a << 16 | conv->b), GUINT_TO_POINTER(conv->ab.msgs));
+		if(conv->ba.msgs)
+			g_hash_table_insert(cells, GUINT_TO_POINTER(conv->b << 16 | conv->a), GUINT_TO_POINTER(conv->ba.msgs));
+	}
+
+	printf("\nMessages sent (rows: sender, columns: receiver, device:object)\n");
+	printf("%-7s", "");
+	for(j = 0; j < eps->len; j++) {
+		col = g_array_index(eps, isi_endpoint_stat_t *, j)->ep;
+		printf(" %02x:%02x  ", col >> 8, col & 0xff);
+	}
+	printf("\n");
+
+	for(i = 0; i < eps->len; i++) {
+		row = g_array_index(eps, isi_endpoint_stat_t *, i)->ep;
+		printf("%02x:%02x  ", row >> 8, row & 0xff);
+
+		for(j = 0; j < eps->len; j++) {
+			col = g_array_index(eps, isi_endpoint_stat_t *, j)->ep;
+			printf(" %7u", GPOINTER_TO_UINT(g_hash_table_lookup(cells, GUINT_TO_POINTER(row << 16 | col))));
+		}
+		printf("\n");
+	}
+
+	g_hash_table_destroy(cells);
+	g_array_free(eps, TRUE);
+}
+
+static void isi_conv_draw_endpoints(isi_conv_t *tap) {
+	GArray *eps = isi_conv_sorted_endpoints(tap, isi_endpoint_cmp);
+	isi_endpoint_stat_t *ep;
+	char *name;
+	guint i;
+
+	printf("%-16s %8s %10s %8s %10s %12s %10s\n", "Endpoint",
+		"Tx", "Bytes", "Rx", "Bytes", "Rel. Start", "Duration");
+
+	for(i = 0; i < eps->len; i++) {
+		ep = g_array_index(eps, isi_endpoint_stat_t *, i);
+		name = isi_conv_ep_str(ep->ep);
+
+		printf("%-16s %8u %10" G_GINT64_MODIFIER "u %8u %10" G_GINT64_MODIFIER "u %12.6f %10.4f\n",
+			name, ep->tx.msgs, ep->tx.bytes, ep->rx.msgs, ep->rx.bytes,
+			nstime_to_sec(&ep->start), isi_conv_duration(&ep->start, &ep->last));
+
+		g_free(name);
+	}
+
+	g_array_free(eps, TRUE);
+}
+
+static void isi_conv_draw(void *tapdata) {
+	isi_conv_t *tap = tapdata;
+
+	printf("\n");
+	printf("=========================================================================================================================\n");
+	printf("ISI %s\n", tap->endpoints ? "Endpoints" : "Conversations");
+	printf("Filter: %s\n", tap->filter ? tap->filter : "<none>");
+	printf("\n");
+
+	if(tap->endpoints) {
+		isi_conv_draw_endpoints(tap);
+	} else {
+		isi_conv_draw_conversations(tap);
+		isi_conv_draw_matrix(tap);
+	}
+
+	printf("=========================================================================================================================\n");
+}
+
+static void isi_conv_init(const char *optarg, void *userdata) {
+	const char *cmd = userdata;
+	isi_conv_t *tap;
+	GString *error;
+
+	tap = g_new0(isi_conv_t, 1);
+	tap->endpoints = !strcmp(cmd, "isi,endpoints");
+	if(!strncmp(optarg, cmd, strlen(cmd)) && optarg[strlen(cmd)] == ',')
+		tap->filter = g_strdup(optarg + strlen(cmd) + 1);
+	tap->convs = g_array_new(FALSE, TRUE, sizeof(isi_conv_stat_t));
+	tap->eps = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
+
+	error = register_tap_listener("isi", tap, tap->filter, TL_REQUIRES_NOTHING,
+		isi_conv_reset, isi_conv_packet, isi_conv_draw);
+	if(error) {
+		fprintf(stderr, "tshark: Couldn't register %s tap: %s\n", cmd, error->str);
+		g_string_free(error, TRUE);
+		g_hash_table_destroy(tap->eps);
+		g_array_free(tap->convs, TRUE);
+		g_free(tap->filter);
+		g_free(tap);
+		exit(1);
+	}
+}
+
+void register_tap_listener_isi_conv(void) {
+	register_stat_cmd_arg("isi,conv", isi_conv_init, (void *) "isi,conv");
+	register_stat_cmd_arg("isi,endpoints", isi_conv_init, (void *) "isi,endpoints");
+}
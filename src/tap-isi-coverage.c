@@ -0,0 +1,446 @@
+/* tap-isi-coverage.c
+ * tshark -z isi,coverage[,out=<file|-|none>][,geohash=<1-12>][,filter] -
+ * joins the latest GPS fix with the serving cell and signal strength
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+#include <epan/packet.h>
+#include <epan/tap.h>
+#include <epan/stat_cmd_args.h>
+
+#include "packet-isi.h"
+#include "isi-network.h"
+#include "isi-gps.h"
+
+#define ISI_COV_GEOHASH_MAX	12
+/* distinct serving cells kept per grid square */
+#define ISI_COV_CELLS		8
+
+typedef struct _isi_cov_cell_t {
+	guint16 lac;
+	guint32 cid;
+	guint32 rows;
+} isi_cov_cell_t;
+
+typedef struct _isi_cov_bin_t {
+	char hash[ISI_COV_GEOHASH_MAX + 1];
+	guint32 rows;
+	guint32 rssi_count;
+	gint rssi_min;
+	gint rssi_max;
+	gint64 rssi_sum;
+	guint ncells;
+	gboolean more_cells;
+	isi_cov_cell_t cell[ISI_COV_CELLS];
+} isi_cov_bin_t;
+
+/* Only the latest fix and network state are kept, rows are written as
+ * the network indications come in. The grid grows with the area covered,
+ * not with the capture. */
+typedef struct _isi_cov_t {
+	char *filter;
+	char *dest;
+	FILE *out;
+	guint precision;
+
+	gboolean has_fix;
+	nstime_t fix_time;
+	double lat;
+	double lon;
+	float eph;
+
+	/* MCC/MNC from GPS_CELL_INFO_*, used if the network sent none */
+	gboolean has_gps_cell;
+	guint16 gps_mcc;
+	guint16 gps_mnc;
+
+	isi_network_tap_info_t net;
+
+	gboolean header;
+	guint32 rows;
+	guint32 no_fix;
+	GHashTable *bins;
+} isi_cov_t;
+
+static void isi_cov_geohash(double lat, double lon, guint precision, char *hash) {
+	static const char base32[] = "0123456789bcdefghjkmnpqrstuvwxyz";
+	double lat_lo = -90, lat_hi = 90, lon_lo = -180, lon_hi = 180, mid;
+	gboolean even = TRUE;
+	guint bit = 0, ch = 0, n = 0;
+
+	while(n < precision) {
+		if(even) {
+			mid = (lon_lo + lon_hi) / 2;
+			ch <<= 1;
+			if(lon >= mid) {
+				ch |= 1;
+				lon_lo = mid;
+			} else {
+				lon_hi = mid;
+			}
+		} else {
+			mid = (lat_lo + lat_hi) / 2;
+			ch <<= 1;
+			if(lat >= mid) {
+				ch |= 1;
+				lat_lo = mid;
+			} else {
+				lat_hi = mid;
+			}
+		}
+
+		even = !even;
+		if(++bit == 5) {
+			hash[n++] = base32[ch];
+			bit = 0;
+			ch = 0;
+		}
+	}
+
+	hash[n] = '\0';
+}
+
+/* 3GPP 24.008 PLMN identity, a 0xf nibble marks a two digit MNC */
+static void isi_cov_plmn(const guint8 *code, char *mcc, char *mnc) {
+	mcc[0] = '0' + (code[0] & 0x0f);
+	mcc[1] = '0' + (code[0] >> 4);
+	mcc[2] = '0' + (code[1] & 0x0f);
+	mcc[3] = '\0';
+
+	mnc[0] = '0' + (code[2] & 0x0f);
+	mnc[1] = '0' + (code[2] >> 4);
+	mnc[2] = (code[1] >> 4) == 0x0f ? '\0' : '0' + (code[1] >> 4);
+	mnc[3] = '\0';
+}
+
+static void isi_cov_bands(GString *s, guint32 bands) {
+	static const struct { guint32 bit; const char *name; } names[] = {
+		{ ISI_NETWORK_GSM_BAND_850,  "GSM850" },
+		{ ISI_NETWORK_GSM_BAND_900,  "GSM900" },
+		{ ISI_NETWORK_GSM_BAND_1800, "GSM1800" },
+		{ ISI_NETWORK_GSM_BAND_1900, "GSM1900" },
+	};
+	gboolean first = TRUE;
+	guint i;
+
+	if(!bands) {
+		g_string_append(s, "all");
+		return;
+	}
+
+	for(i = 0; i < G_N_ELEMENTS(names); i++) {
+		if(!(bands & names[i].bit))
+			continue;
+		g_string_append_printf(s, "%s%s", first ? "" : "/", names[i].name);
+		first = FALSE;
+	}
+}
+
+static void isi_cov_bin_add(isi_cov_t *cov) {
+	char hash[ISI_COV_GEOHASH_MAX + 1];
+	isi_cov_bin_t *bin;
+	guint i;
+
+	isi_cov_geohash(cov->lat, cov->lon, cov->precision, hash);
+
+	bin = g_hash_table_lookup(cov->bins, hash);
+	if(!bin) {
+		bin = g_new0(isi_cov_bin_t, 1);
+		strcpy(bin->hash, hash);
+		g_hash_table_insert(cov->bins, bin->hash, bin);
+	}
+
+	bin->rows++;
+
+	if(cov->net.has_rssi) {
+		if(!bin->rssi_count || cov->net.rssi_dbm < bin->rssi_min)
+			bin->rssi_min = cov->net.rssi_dbm;
+		if(!bin->rssi_count || cov->net.rssi_dbm > bin->rssi_max)
+			bin->rssi_max = cov->net.rssi_dbm;
+		bin->rssi_sum += cov->net.rssi_dbm;
+		bin->rssi_count++;
+	}
+
+	if(!cov->net.has_cell)
+		return;
+
+	for(i = 0; i < bin->ncells; i++) {
+		if(bin->cell[i].lac == cov->net.lac && bin->cell[i].cid == cov->net.cid) {
+			bin->cell[i].rows++;
+			return;
+		}
+	}
+
+	if(bin->ncells == ISI_COV_CELLS) {
+		bin->more_cells = TRUE;
+		return;
+	}
+
+	bin->cell[bin->ncells].lac = cov->net.lac;
+	bin->cell[bin->ncells].cid = cov->net.cid;
+	bin->cell[bin->ncells].rows = 1;
+	bin->ncells++;
+}
+
+static void isi_cov_write_row(isi_cov_t *cov, packet_info *pinfo) {
+	GString *s = g_string_new("");
+	char mcc[4], mnc[4];
+	nstime_t age;
+
+	if(!cov->header) {
+		g_string_append(s, "frame,rel_time,lat,lon,eph,fix_age,mcc,mnc,lac,cid,rat,band,rssi_bars,rssi_dbm\n");
+		cov->header = TRUE;
+	}
+
+	nstime_delta(&age, &pinfo->fd->rel_ts, &cov->fix_time);
+	g_string_append_printf(s, "%u,%.6f,%.7f,%.7f,%.2f,%.3f,", pinfo->fd->num, nstime_to_sec(&pinfo->fd->rel_ts),
+		cov->lat, cov->lon, cov->eph, nstime_to_sec(&age));
+
+	if(cov->net.has_operator) {
+		isi_cov_plmn(cov->net.operator_code, mcc, mnc);
+		g_string_append_printf(s, "%s,%s,", mcc, mnc);
+	} else if(cov->has_gps_cell) {
+		g_string_append_printf(s, "%u,%02u,", cov->gps_mcc, cov->gps_mnc);
+	} else {
+		g_string_append(s, ",,");
+	}
+
+	if(cov->net.has_cell)
+		g_string_append_printf(s, "%u,%u,", cov->net.lac, cov->net.cid);
+	else
+		g_string_append(s, ",,");
+
+	if(cov->net.has_rat)
+		g_string_append(s, isi_network_rat_str(cov->net.rat));
+	g_string_append_c(s, ',');
+
+	if(cov->net.has_operator)
+		isi_cov_bands(s, cov->net.bands);
+	g_string_append_c(s, ',');
+
+	if(cov->net.has_rssi)
+		g_string_append_printf(s, "%u,%d\n", cov->net.rssi_bars, cov->net.rssi_dbm);
+	else
+		g_string_append(s, ",\n");
+
+	fputs(s->str, cov->out);
+	fflush(cov->out);
+	g_string_free(s, TRUE);
+}
+
+static void isi_cov_reset(void *tapdata) {
+	isi_cov_t *cov = tapdata;
+
+	cov->has_fix = FALSE;
+	cov->has_gps_cell = FALSE;
+	memset(&cov->net, 0, sizeof(cov->net));
+	cov->rows = 0;
+	cov->no_fix = 0;
+	g_hash_table_remove_all(cov->bins);
+}
+
+static int isi_cov_gps_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt, const void *data) {
+	isi_cov_t *cov = tapdata;
+	const isi_gps_tap_info_t *info = data;
+
+	/* the last position is no longer valid without a lock */
+	if(info->msg_id == ISI_GPS_STATUS_IND && info->status != ISI_GPS_LOCK)
+		cov->has_fix = FALSE;
+
+	if(info->has_cell) {
+		cov->has_gps_cell = TRUE;
+		cov->gps_mcc = info->mcc;
+		cov->gps_mnc = info->mnc;
+	}
+
+	if(info->has_position) {
+		cov->has_fix = TRUE;
+		cov->fix_time = pinfo->fd->rel_ts;
+		cov->lat = info->lat;
+		cov->lon = info->lon;
+		cov->eph = info->eph;
+	}
+
+	return 0;
+}
+
+static int isi_cov_net_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt, const void *data) {
+	isi_cov_t *cov = tapdata;
+	const isi_network_tap_info_t *info = data;
+
+	if(info->has_cell) {
+		cov->net.has_cell = TRUE;
+		cov->net.lac = info->lac;
+		cov->net.cid = info->cid;
+	}
+	if(info->has_rat) {
+		cov->net.has_rat = TRUE;
+		cov->net.rat = info->rat;
+	}
+	if(info->has_reg) {
+		cov->net.has_reg = TRUE;
+		cov->net.reg_status = info->reg_status;
+	}
+	if(info->has_rssi) {
+		cov->net.has_rssi = TRUE;
+		cov->net.rssi_bars = info->rssi_bars;
+		cov->net.rssi_dbm = info->rssi_dbm;
+	}
+	if(info->has_operator) {
+		cov->net.has_operator = TRUE;
+		memcpy(cov->net.operator_code, info->operator_code, sizeof(cov->net.operator_code));
+		cov->net.bands = info->bands;
+	}
+
+	if(!cov->has_fix) {
+		cov->no_fix++;
+		return 0;
+	}
+
+	if(cov->out)
+		isi_cov_write_row(cov, pinfo);
+	if(cov->precision)
+		isi_cov_bin_add(cov);
+	cov->rows++;
+
+	return 1;
+}
+
+static void isi_cov_collect_bin(gpointer key, gpointer value, gpointer user_data) {
+	g_array_append_val((GArray *) user_data, value);
+}
+
+static gint isi_cov_bin_cmp(gconstpointer a, gconstpointer b) {
+	const isi_cov_bin_t *ba = *(const isi_cov_bin_t * const *) a;
+	const isi_cov_bin_t *bb = *(const isi_cov_bin_t * const *) b;
+
+	return strcmp(ba->hash, bb->hash);
+}
+
+static void isi_cov_draw(void *tapdata) {
+	isi_cov_t *cov = tapdata;
+	const isi_cov_bin_t *bin;
+	const isi_cov_cell_t *top;
+	GArray *bins;
+	FILE *report = stdout;
+	guint i, c;
+
+	/* do not mix the summary into the rows on stdout */
+	if(cov->out == stdout)
+		report = stderr;
+
+	fprintf(report, "\n");
+	fprintf(report, "=========================================================================================\n");
+	fprintf(report, "ISI Coverage\n");
+	fprintf(report, "Filter: %s\n", cov->filter ? cov->filter : "<none>");
+	fprintf(report, "Rows: %u  Network indications without a fix: %u\n", cov->rows, cov->no_fix);
+
+	if(cov->precision) {
+		bins = g_array_new(FALSE, FALSE, sizeof(isi_cov_bin_t *));
+		g_hash_table_foreach(cov->bins, isi_cov_collect_bin, bins);
+		g_array_sort(bins, isi_cov_bin_cmp);
+
+		fprintf(report, "\n%-12s %7s %7s %8s %8s %8s %6s  %s\n", "Geohash", "Rows", "RSSI n",
+			"dBm min", "dBm mean", "dBm max", "Cells", "Top cell (LAC/CID)");
+		for(i = 0; i < bins->len; i++) {
+			bin = g_array_index(bins, isi_cov_bin_t *, i);
+
+			top = NULL;
+			for(c = 0; c < bin->ncells; c++)
+				if(!top || bin->cell[c].rows > top->rows)
+					top = &bin->cell[c];
+
+			fprintf(report, "%-12s %7u %7u ", bin->hash, bin->rows, bin->rssi_count);
+			if(bin->rssi_count)
+				fprintf(report, "%8d %8.1f %8d ", bin->rssi_min, (gdouble) bin->rssi_sum / bin->rssi_count, bin->rssi_max);
+			else
+				fprintf(report, "%8s %8s %8s ", "-", "-", "-");
+			fprintf(report, "%5u%s  ", bin->ncells, bin->more_cells ? "+" : " ");
+			if(top)
+				fprintf(report, "0x%04x/0x%08x\n", top->lac, top->cid);
+			else
+				fprintf(report, "-\n");
+		}
+
+		g_array_free(bins, TRUE);
+	}
+
+	fprintf(report, "=========================================================================================\n");
+}
+
+static void isi_cov_init(const char *optarg, void *userdata) {
+	isi_cov_t *cov;
+	GString *error;
+	gchar **args;
+	guint i;
+
+	cov = g_new0(isi_cov_t, 1);
+	cov->dest = g_strdup("-");
+
+	/* options first, everything after them is the filter */
+	args = g_strsplit(optarg, ",", 0);
+	for(i = 2; args[i]; i++) {
+		if(!strncmp(args[i], "out=", 4)) {
+			g_free(cov->dest);
+			cov->dest = g_strdup(args[i] + 4);
+		} else if(!strncmp(args[i], "geohash=", 8)) {
+			cov->precision = atoi(args[i] + 8);
+			if(cov->precision < 1 || cov->precision > ISI_COV_GEOHASH_MAX) {
+				fprintf(stderr, "tshark: isi,coverage: geohash precision must be 1-%d\n", ISI_COV_GEOHASH_MAX);
+				exit(1);
+			}
+		} else {
+			break;
+		}
+	}
+	if(args[i])
+		cov->filter = g_strjoinv(",", args + i);
+	g_strfreev(args);
+
+	if(!strcmp(cov->dest, "-")) {
+		cov->out = stdout;
+	} else if(strcmp(cov->dest, "none")) {
+		cov->out = fopen(cov->dest, "w");
+		if(!cov->out) {
+			fprintf(stderr, "tshark: isi,coverage: can't open %s\n", cov->dest);
+			exit(1);
+		}
+	}
+
+	cov->bins = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, g_free);
+
+	/* the filter selects the network indications, every fix is needed */
+	error = register_tap_listener("isi.gps", cov, NULL, TL_REQUIRES_NOTHING,
+		NULL, isi_cov_gps_packet, NULL);
+	if(!error)
+		error = register_tap_listener("isi.network", cov, cov->filter, TL_REQUIRES_NOTHING,
+			isi_cov_reset, isi_cov_net_packet, isi_cov_draw);
+	if(error) {
+		fprintf(stderr, "tshark: Couldn't register isi,coverage tap: %s\n", error->str);
+		g_string_free(error, TRUE);
+		exit(1);
+	}
+}
+
+void register_tap_listener_isi_coverage(void) {
+	register_stat_cmd_arg("isi,coverage", isi_cov_init, NULL);
+}
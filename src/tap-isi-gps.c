@@ -0,0 +1,290 @@
+/* tap-isi-gps.c
+ * tshark -z isi,gps[,filter] - GPS power cycles, time to first fix and
+ * duty cycle
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+#include <epan/packet.h>
+#include <epan/tap.h>
+#include <epan/stat_cmd_args.h>
+
+#include "packet-isi.h"
+#include "isi-gps.h"
+
+/* A power cycle starts with the first status other than GPS_DISABLED, or
+ * a position, and ends with GPS_DISABLED. The payload of the power
+ * messages is not decoded, an off request can't be told from an on
+ * request, so GPS_POWER_STATUS_REQ does not start a cycle.
+ *
+ * A fix is GPS_LOCK or a position in GPS_DATA_IND. The start is warm if
+ * the previous fix is younger than the broadcast ephemeris (~4 hours),
+ * otherwise, or without any earlier fix in the capture, it is cold. */
+#define ISI_GPS_WARM_MAX	(4 * 3600.0)
+
+typedef struct _isi_gps_cycle_t {
+	guint32 frame;
+	nstime_t start;
+	nstime_t end;
+	gboolean cold;
+	gboolean fixed;
+	gdouble ttff;
+	gdouble locked;		/* seconds with a fix */
+	guint32 positions;
+} isi_gps_cycle_t;
+
+typedef struct _isi_gps_t {
+	char *filter;
+
+	gboolean powered;
+	gboolean locked;
+	nstime_t lock_since;
+	gboolean have_fix;
+	nstime_t last_fix;
+	nstime_t last;
+
+	GArray *cycles;
+} isi_gps_t;
+
+static gdouble isi_gps_delta(const nstime_t *end, const nstime_t *start) {
+	nstime_t delta;
+
+	nstime_delta(&delta, end, start);
+	return nstime_to_sec(&delta);
+}
+
+static isi_gps_cycle_t *isi_gps_cur(isi_gps_t *gps) {
+	return &g_array_index(gps->cycles, isi_gps_cycle_t, gps->cycles->len - 1);
+}
+
+static void isi_gps_power_on(isi_gps_t *gps, packet_info *pinfo) {
+	isi_gps_cycle_t cycle;
+	const nstime_t *now = &pinfo->fd->rel_ts;
+
+	if(gps->powered)
+		return;
+
+	memset(&cycle, 0, sizeof(cycle));
+	cycle.frame = pinfo->fd->num;
+	cycle.start = *now;
+	cycle.cold = !gps->have_fix || isi_gps_delta(now, &gps->last_fix) > ISI_GPS_WARM_MAX;
+	g_array_append_val(gps->cycles, cycle);
+
+	gps->powered = TRUE;
+}
+
+static void isi_gps_fix(isi_gps_t *gps, const nstime_t *now) {
+	isi_gps_cycle_t *cycle = isi_gps_cur(gps);
+
+	if(!cycle->fixed) {
+		cycle->fixed = TRUE;
+		cycle->ttff = isi_gps_delta(now, &cycle->start);
+	}
+
+	if(!gps->locked) {
+		gps->locked = TRUE;
+		gps->lock_since = *now;
+	}
+
+	gps->have_fix = TRUE;
+	gps->last_fix = *now;
+}
+
+static void isi_gps_unlock(isi_gps_t *gps, const nstime_t *now) {
+	if(!gps->locked)
+		return;
+
+	isi_gps_cur(gps)->locked += isi_gps_delta(now, &gps->lock_since);
+	gps->locked = FALSE;
+	gps->last_fix = *now;
+}
+
+static void isi_gps_power_off(isi_gps_t *gps, const nstime_t *now) {
+	if(!gps->powered)
+		return;
+
+	isi_gps_unlock(gps, now);
+	isi_gps_cur(gps)->end = *now;
+	gps->powered = FALSE;
+}
+
+static void isi_gps_reset(void *tapdata) {
+	isi_gps_t *gps = tapdata;
+
+	gps->powered = FALSE;
+	gps->locked = FALSE;
+	gps->have_fix = FALSE;
+	nstime_set_zero(&gps->last);
+	g_array_set_size(gps->cycles, 0);
+}
+
+static int isi_gps_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt, const void *data) {
+	isi_gps_t *gps = tapdata;
+	const isi_gps_tap_info_t *info = data;
+	const nstime_t *now = &pinfo->fd->rel_ts;
+
+	gps->last = *now;
+
+	switch(info->msg_id) {
+		case ISI_GPS_STATUS_IND:
+			if(info->status == ISI_GPS_DISABLED) {
+				isi_gps_power_off(gps, now);
+				break;
+			}
+
+			isi_gps_power_on(gps, pinfo);
+			if(info->status == ISI_GPS_LOCK)
+				isi_gps_fix(gps, now);
+			else
+				isi_gps_unlock(gps, now);
+			break;
+		case ISI_GPS_DATA_IND:
+			if(!info->has_position)
+				return 0;
+
+			isi_gps_power_on(gps, pinfo);
+			isi_gps_fix(gps, now);
+			isi_gps_cur(gps)->positions++;
+			break;
+		default:
+			return 0;
+	}
+
+	return 1;
+}
+
+static gint isi_gps_double_cmp(gconstpointer a, gconstpointer b) {
+	gdouble da = *(const gdouble *) a;
+	gdouble db = *(const gdouble *) b;
+
+	return da < db ? -1 : da > db ? 1 : 0;
+}
+
+/* nearest rank, values must be sorted */
+static gdouble isi_gps_percentile(GArray *values, guint p) {
+	guint rank = (p * values->len + 99) / 100;
+
+	return g_array_index(values, gdouble, rank ? rank - 1 : 0);
+}
+
+static void isi_gps_print_dist(const char *name, GArray *values) {
+	if(!values->len) {
+		printf("%-16s %6u\n", name, 0);
+		return;
+	}
+
+	g_array_sort(values, isi_gps_double_cmp);
+	printf("%-16s %6u %10.3f %10.3f %10.3f %10.3f %10.3f\n", name, values->len,
+		g_array_index(values, gdouble, 0), isi_gps_percentile(values, 50),
+		isi_gps_percentile(values, 90), isi_gps_percentile(values, 95),
+		g_array_index(values, gdouble, values->len - 1));
+}
+
+static void isi_gps_draw(void *tapdata) {
+	isi_gps_t *gps = tapdata;
+	isi_gps_cycle_t cycle;
+	GArray *cold, *warm, *on;
+	gdouble duration, capture, powered = 0, locked = 0;
+	guint i;
+
+	cold = g_array_new(FALSE, FALSE, sizeof(gdouble));
+	warm = g_array_new(FALSE, FALSE, sizeof(gdouble));
+	on = g_array_new(FALSE, FALSE, sizeof(gdouble));
+
+	printf("\n");
+	printf("=========================================================================================\n");
+	printf("ISI GPS Power Cycles\n");
+	printf("Filter: %s\n", gps->filter ? gps->filter : "<none>");
+	printf("Cycles start at the first GPS_STATUS_IND or position, the power\n"
+		"request payload is not decoded\n");
+
+	printf("\n%4s %8s %12s %12s %5s %10s %12s %8s %9s\n", "#", "Frame", "Start", "Powered",
+		"Type", "TTFF", "Locked", "No lock", "Positions");
+	for(i = 0; i < gps->cycles->len; i++) {
+		cycle = g_array_index(gps->cycles, isi_gps_cycle_t, i);
+
+		/* close the running cycle at the last GPS message */
+		if(gps->powered && i == gps->cycles->len - 1) {
+			cycle.end = gps->last;
+			if(gps->locked)
+				cycle.locked += isi_gps_delta(&gps->last, &gps->lock_since);
+		}
+
+		duration = isi_gps_delta(&cycle.end, &cycle.start);
+		powered += duration;
+		locked += cycle.locked;
+		g_array_append_val(on, duration);
+		if(cycle.fixed)
+			g_array_append_val(cycle.cold ? cold : warm, cycle.ttff);
+
+		printf("%4u %8u %12.6f %12.6f %5s ", i + 1, cycle.frame, nstime_to_sec(&cycle.start),
+			duration, cycle.cold ? "cold" : "warm");
+		if(cycle.fixed)
+			printf("%10.3f ", cycle.ttff);
+		else
+			printf("%10s ", "-");
+		printf("%12.6f %7.1f%% %9u%s\n", cycle.locked,
+			duration > 0 ? 100.0 * (duration - cycle.locked) / duration : 0.0,
+			cycle.positions, gps->powered && i == gps->cycles->len - 1 ? " (running)" : "");
+	}
+
+	capture = nstime_to_sec(&gps->last);
+	printf("\nPowered: %.3f s of %.3f s (%.1f%%)\n", powered, capture,
+		capture > 0 ? 100.0 * powered / capture : 0.0);
+	printf("Powered without lock: %.3f s (%.1f%% of powered)\n", powered - locked,
+		powered > 0 ? 100.0 * (powered - locked) / powered : 0.0);
+
+	printf("\n%-16s %6s %10s %10s %10s %10s %10s\n", "Seconds", "Count", "Min", "P50", "P90", "P95", "Max");
+	isi_gps_print_dist("Cold TTFF", cold);
+	isi_gps_print_dist("Warm TTFF", warm);
+	isi_gps_print_dist("Powered", on);
+
+	printf("=========================================================================================\n");
+
+	g_array_free(cold, TRUE);
+	g_array_free(warm, TRUE);
+	g_array_free(on, TRUE);
+}
+
+static void isi_gps_init(const char *optarg, void *userdata) {
+	isi_gps_t *gps;
+	GString *error;
+
+	gps = g_new0(isi_gps_t, 1);
+	if(!strncmp(optarg, "isi,gps,", 8))
+		gps->filter = g_strdup(optarg + 8);
+	gps->cycles = g_array_new(FALSE, FALSE, sizeof(isi_gps_cycle_t));
+
+	error = register_tap_listener("isi.gps", gps, gps->filter, TL_REQUIRES_NOTHING,
+		isi_gps_reset, isi_gps_packet, isi_gps_draw);
+	if(error) {
+		fprintf(stderr, "tshark: Couldn't register isi,gps tap: %s\n", error->str);
+		g_string_free(error, TRUE);
+		g_array_free(gps->cycles, TRUE);
+		g_free(gps->filter);
+		g_free(gps);
+		exit(1);
+	}
+}
+
+void register_tap_listener_isi_gps(void) {
+	register_stat_cmd_arg("isi,gps", isi_gps_init, NULL);
+}
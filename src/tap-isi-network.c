@@ -0,0 +1,300 @@
+/* tap-isi-network.c
+ * tshark -z isi,network[,filter] - serving cell, RAT and registration
+ * timeline with the time spent per RAT and per cell
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+#include <epan/packet.h>
+#include <epan/tap.h>
+#include <epan/stat_cmd_args.h>
+
+#include "packet-isi.h"
+#include "isi-network.h"
+
+enum {
+	ISI_NET_EV_CELL,	/* cell change within the location area */
+	ISI_NET_EV_LAC,		/* cell change to another location area */
+	ISI_NET_EV_RAT,
+	ISI_NET_EV_REG
+};
+
+static const char *isi_net_ev_names[] = {
+	"Cell", "LAC", "RAT", "Registration"
+};
+
+/* Only changes are stored, so the timeline stays small */
+typedef struct _isi_net_event_t {
+	nstime_t time;
+	guint32 frame;
+	guint8 kind;
+	gboolean first;		/* no previous value */
+	guint16 from_lac;
+	guint32 from_cid;
+	guint16 to_lac;
+	guint32 to_cid;
+	guint8 from;		/* RAT or registration status */
+	guint8 to;
+} isi_net_event_t;
+
+typedef struct _isi_net_cell_t {
+	guint16 lac;
+	guint32 cid;
+	guint32 visits;
+	gdouble seconds;
+} isi_net_cell_t;
+
+typedef struct _isi_net_t {
+	char *filter;
+
+	isi_network_tap_info_t cur;
+	nstime_t cell_since;
+	nstime_t rat_since;
+	nstime_t last;
+
+	GArray *events;
+	/* isi_net_cell_t by (lac, cid), key is the value itself */
+	GHashTable *cells;
+	guint32 rat_changes;
+	gdouble rat_seconds[256];
+} isi_net_t;
+
+static guint isi_net_cell_hash(gconstpointer key) {
+	const isi_net_cell_t *cell = key;
+
+	return (cell->lac << 16) ^ cell->cid;
+}
+
+static gboolean isi_net_cell_equal(gconstpointer a, gconstpointer b) {
+	const isi_net_cell_t *ca = a;
+	const isi_net_cell_t *cb = b;
+
+	return ca->lac == cb->lac && ca->cid == cb->cid;
+}
+
+static gdouble isi_net_delta(const nstime_t *end, const nstime_t *start) {
+	nstime_t delta;
+
+	nstime_delta(&delta, end, start);
+	return nstime_to_sec(&delta);
+}
+
+static isi_net_cell_t *isi_net_get_cell(isi_net_t *net, guint16 lac, guint32 cid) {
+	isi_net_cell_t key, *cell;
+
+	key.lac = lac;
+	key.cid = cid;
+
+	cell = g_hash_table_lookup(net->cells, &key);
+	if(!cell) {
+		cell = g_new0(isi_net_cell_t, 1);
+		cell->lac = lac;
+		cell->cid = cid;
+		g_hash_table_insert(net->cells, cell, cell);
+	}
+
+	return cell;
+}
+
+static void isi_net_reset(void *tapdata) {
+	isi_net_t *net = tapdata;
+
+	memset(&net->cur, 0, sizeof(net->cur));
+	g_array_set_size(net->events, 0);
+	g_hash_table_remove_all(net->cells);
+	net->rat_changes = 0;
+	memset(net->rat_seconds, 0, sizeof(net->rat_seconds));
+}
+
+static isi_net_event_t *isi_net_add_event(isi_net_t *net, packet_info *pinfo, guint8 kind, gboolean first) {
+	isi_net_event_t ev;
+
+	memset(&ev, 0, sizeof(ev));
+	ev.time = pinfo->fd->rel_ts;
+	ev.frame = pinfo->fd->num;
+	ev.kind = kind;
+	ev.first = first;
+	g_array_append_val(net->events, ev);
+
+	return &g_array_index(net->events, isi_net_event_t, net->events->len - 1);
+}
+
+static int isi_net_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt, const void *data) {
+	isi_net_t *net = tapdata;
+	const isi_network_tap_info_t *info = data;
+	const nstime_t *now = &pinfo->fd->rel_ts;
+	isi_net_event_t *ev;
+
+	if(info->has_cell && (!net->cur.has_cell || net->cur.lac != info->lac || net->cur.cid != info->cid)) {
+		ev = isi_net_add_event(net, pinfo, net->cur.has_cell && net->cur.lac != info->lac ? ISI_NET_EV_LAC : ISI_NET_EV_CELL, !net->cur.has_cell);
+		ev->from_lac = net->cur.lac;
+		ev->from_cid = net->cur.cid;
+		ev->to_lac = info->lac;
+		ev->to_cid = info->cid;
+
+		if(net->cur.has_cell)
+			isi_net_get_cell(net, net->cur.lac, net->cur.cid)->seconds += isi_net_delta(now, &net->cell_since);
+		isi_net_get_cell(net, info->lac, info->cid)->visits++;
+
+		net->cur.has_cell = TRUE;
+		net->cur.lac = info->lac;
+		net->cur.cid = info->cid;
+		net->cell_since = *now;
+	}
+
+	if(info->has_rat && (!net->cur.has_rat || net->cur.rat != info->rat)) {
+		ev = isi_net_add_event(net, pinfo, ISI_NET_EV_RAT, !net->cur.has_rat);
+		ev->from = net->cur.rat;
+		ev->to = info->rat;
+
+		if(net->cur.has_rat) {
+			net->rat_seconds[net->cur.rat] += isi_net_delta(now, &net->rat_since);
+			net->rat_changes++;
+		}
+
+		net->cur.has_rat = TRUE;
+		net->cur.rat = info->rat;
+		net->rat_since = *now;
+	}
+
+	if(info->has_reg && (!net->cur.has_reg || net->cur.reg_status != info->reg_status)) {
+		ev = isi_net_add_event(net, pinfo, ISI_NET_EV_REG, !net->cur.has_reg);
+		ev->from = net->cur.reg_status;
+		ev->to = info->reg_status;
+
+		net->cur.has_reg = TRUE;
+		net->cur.reg_status = info->reg_status;
+	}
+
+	net->last = *now;
+
+	return 1;
+}
+
+static char *isi_net_event_value(const isi_net_event_t *ev, gboolean from) {
+	switch(ev->kind) {
+		case ISI_NET_EV_CELL:
+		case ISI_NET_EV_LAC:
+			return g_strdup_printf("0x%04x/0x%08x", from ? ev->from_lac : ev->to_lac, from ? ev->from_cid : ev->to_cid);
+		case ISI_NET_EV_RAT:
+			return g_strdup(isi_network_rat_str(from ? ev->from : ev->to));
+		default:
+			return g_strdup(isi_network_reg_status_str(from ? ev->from : ev->to));
+	}
+}
+
+static void isi_net_collect_cell(gpointer key, gpointer value, gpointer user_data) {
+	g_array_append_val((GArray *) user_data, value);
+}
+
+/* longest first */
+static gint isi_net_cell_cmp(gconstpointer a, gconstpointer b) {
+	const isi_net_cell_t *ca = *(const isi_net_cell_t * const *) a;
+	const isi_net_cell_t *cb = *(const isi_net_cell_t * const *) b;
+
+	return ca->seconds < cb->seconds ? 1 : ca->seconds > cb->seconds ? -1 : 0;
+}
+
+static void isi_net_draw(void *tapdata) {
+	isi_net_t *net = tapdata;
+	const isi_net_event_t *ev;
+	isi_net_cell_t *cell;
+	GArray *cells;
+	gdouble rat_seconds[256];
+	char *from, *to;
+	guint i;
+
+	/* close the open intervals at the last network message */
+	memcpy(rat_seconds, net->rat_seconds, sizeof(rat_seconds));
+	if(net->cur.has_rat)
+		rat_seconds[net->cur.rat] += isi_net_delta(&net->last, &net->rat_since);
+
+	cells = g_array_new(FALSE, FALSE, sizeof(isi_net_cell_t *));
+	g_hash_table_foreach(net->cells, isi_net_collect_cell, cells);
+	if(net->cur.has_cell)
+		isi_net_get_cell(net, net->cur.lac, net->cur.cid)->seconds += isi_net_delta(&net->last, &net->cell_since);
+	g_array_sort(cells, isi_net_cell_cmp);
+
+	printf("\n");
+	printf("=========================================================================================\n");
+	printf("ISI Network Timeline\n");
+	printf("Filter: %s\n", net->filter ? net->filter : "<none>");
+
+	printf("\n%12s %8s  %-13s %-36s %s\n", "Time", "Frame", "Event", "From", "To");
+	for(i = 0; i < net->events->len; i++) {
+		ev = &g_array_index(net->events, isi_net_event_t, i);
+		from = ev->first ? g_strdup("-") : isi_net_event_value(ev, TRUE);
+		to = isi_net_event_value(ev, FALSE);
+
+		printf("%12.6f %8u  %-13s %-36s %s\n", nstime_to_sec(&ev->time), ev->frame,
+			isi_net_ev_names[ev->kind], from, to);
+
+		g_free(from);
+		g_free(to);
+	}
+
+	printf("\nTime per RAT (%u changes)\n", net->rat_changes);
+	printf("%-20s %12s\n", "RAT", "Seconds");
+	for(i = 0; i < 256; i++)
+		if(rat_seconds[i] > 0 || (net->cur.has_rat && net->cur.rat == i))
+			printf("%-20s %12.6f\n", isi_network_rat_str(i), rat_seconds[i]);
+
+	printf("\nTime per cell\n");
+	printf("%-8s %-12s %8s %12s\n", "LAC", "Cell ID", "Visits", "Seconds");
+	for(i = 0; i < cells->len; i++) {
+		cell = g_array_index(cells, isi_net_cell_t *, i);
+		printf("0x%04x   0x%08x   %8u %12.6f\n", cell->lac, cell->cid, cell->visits, cell->seconds);
+	}
+
+	printf("=========================================================================================\n");
+
+	/* undo the open interval, draw may be called again on live captures */
+	if(net->cur.has_cell)
+		isi_net_get_cell(net, net->cur.lac, net->cur.cid)->seconds -= isi_net_delta(&net->last, &net->cell_since);
+	g_array_free(cells, TRUE);
+}
+
+static void isi_net_init(const char *optarg, void *userdata) {
+	isi_net_t *net;
+	GString *error;
+
+	net = g_new0(isi_net_t, 1);
+	if(!strncmp(optarg, "isi,network,", 12))
+		net->filter = g_strdup(optarg + 12);
+	net->events = g_array_new(FALSE, FALSE, sizeof(isi_net_event_t));
+	net->cells = g_hash_table_new_full(isi_net_cell_hash, isi_net_cell_equal, NULL, g_free);
+
+	error = register_tap_listener("isi.network", net, net->filter, TL_REQUIRES_NOTHING,
+		isi_net_reset, isi_net_packet, isi_net_draw);
+	if(error) {
+		fprintf(stderr, "tshark: Couldn't register isi,network tap: %s\n", error->str);
+		g_string_free(error, TRUE);
+		g_hash_table_destroy(net->cells);
+		g_array_free(net->events, TRUE);
+		g_free(net->filter);
+		g_free(net);
+		exit(1);
+	}
+}
+
+void register_tap_listener_isi_network(void) {
+	register_stat_cmd_arg("isi,network", isi_net_init, NULL);
+}
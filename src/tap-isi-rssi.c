@@ -0,0 +1,180 @@
+/* tap-isi-rssi.c
+ * tshark -z isi,rssi[,filter] - downsampled signal strength series
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+#include <epan/packet.h>
+#include <epan/tap.h>
+#include <epan/stat_cmd_args.h>
+
+#include "packet-isi.h"
+#include "isi-network.h"
+
+/* The series has a fixed number of buckets. They start one second wide
+ * and whenever the capture outgrows them, neighbours are merged and the
+ * width doubles. A 24 hour capture ends up with ~3 minute buckets. */
+#define ISI_RSSI_BUCKETS	512
+#define ISI_RSSI_WIDTH		1.0
+
+typedef struct _isi_rssi_agg_t {
+	guint32 count;
+	gint min;
+	gint max;
+	gint64 sum;
+} isi_rssi_agg_t;
+
+typedef struct _isi_rssi_bucket_t {
+	isi_rssi_agg_t bars;
+	isi_rssi_agg_t dbm;
+} isi_rssi_bucket_t;
+
+typedef struct _isi_rssi_t {
+	char *filter;
+	gdouble width;
+	guint used;
+	guint32 samples;
+	isi_rssi_bucket_t bucket[ISI_RSSI_BUCKETS];
+} isi_rssi_t;
+
+static void isi_rssi_agg_add(isi_rssi_agg_t *agg, gint value) {
+	if(!agg->count || value < agg->min)
+		agg->min = value;
+	if(!agg->count || value > agg->max)
+		agg->max = value;
+	agg->sum += value;
+	agg->count++;
+}
+
+static void isi_rssi_agg_merge(isi_rssi_agg_t *agg, const isi_rssi_agg_t *other) {
+	if(!other->count)
+		return;
+
+	if(!agg->count || other->min < agg->min)
+		agg->min = other->min;
+	if(!agg->count || other->max > agg->max)
+		agg->max = other->max;
+	agg->sum += other->sum;
+	agg->count += other->count;
+}
+
+/* halve the resolution: bucket i takes over 2i and 2i+1 */
+static void isi_rssi_compact(isi_rssi_t *rssi) {
+	isi_rssi_bucket_t merged;
+	guint i;
+
+	for(i = 0; i < ISI_RSSI_BUCKETS / 2; i++) {
+		merged = rssi->bucket[2 * i];
+		isi_rssi_agg_merge(&merged.bars, &rssi->bucket[2 * i + 1].bars);
+		isi_rssi_agg_merge(&merged.dbm, &rssi->bucket[2 * i + 1].dbm);
+		rssi->bucket[i] = merged;
+	}
+
+	memset(&rssi->bucket[ISI_RSSI_BUCKETS / 2], 0, (ISI_RSSI_BUCKETS / 2) * sizeof(isi_rssi_bucket_t));
+	rssi->used = (rssi->used + 1) / 2;
+	rssi->width *= 2;
+}
+
+static void isi_rssi_reset(void *tapdata) {
+	isi_rssi_t *rssi = tapdata;
+
+	rssi->width = ISI_RSSI_WIDTH;
+	rssi->used = 0;
+	rssi->samples = 0;
+	memset(rssi->bucket, 0, sizeof(rssi->bucket));
+}
+
+static int isi_rssi_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt, const void *data) {
+	isi_rssi_t *rssi = tapdata;
+	const isi_network_tap_info_t *info = data;
+	gdouble t = nstime_to_sec(&pinfo->fd->rel_ts);
+	guint idx;
+
+	if(!info->has_rssi)
+		return 0;
+
+	if(t < 0)
+		t = 0;
+
+	while(t / rssi->width >= ISI_RSSI_BUCKETS)
+		isi_rssi_compact(rssi);
+
+	idx = (guint) (t / rssi->width);
+	isi_rssi_agg_add(&rssi->bucket[idx].bars, info->rssi_bars);
+	isi_rssi_agg_add(&rssi->bucket[idx].dbm, info->rssi_dbm);
+
+	rssi->used = MAX(rssi->used, idx + 1);
+	rssi->samples++;
+
+	return 1;
+}
+
+static void isi_rssi_draw(void *tapdata) {
+	isi_rssi_t *rssi = tapdata;
+	const isi_rssi_bucket_t *b;
+	guint i;
+
+	printf("\n");
+	printf("=========================================================================================\n");
+	printf("ISI Signal Strength\n");
+	printf("Filter: %s\n", rssi->filter ? rssi->filter : "<none>");
+	printf("Samples: %u  Bucket width: %.0f s\n", rssi->samples, rssi->width);
+	printf("\n");
+	printf("%12s %12s %7s %6s %6s %6s %8s %8s %8s\n", "Start", "End", "Samples",
+		"% min", "% mean", "% max", "dBm min", "dBm mean", "dBm max");
+
+	/* empty buckets are gaps in the series */
+	for(i = 0; i < rssi->used; i++) {
+		b = &rssi->bucket[i];
+		if(!b->bars.count)
+			continue;
+
+		printf("%12.3f %12.3f %7u %6d %6.1f %6d %8d %8.1f %8d\n", i * rssi->width, (i + 1) * rssi->width, b->bars.count,
+			b->bars.min, (gdouble) b->bars.sum / b->bars.count, b->bars.max,
+			b->dbm.min, (gdouble) b->dbm.sum / b->dbm.count, b->dbm.max);
+	}
+
+	printf("=========================================================================================\n");
+}
+
+static void isi_rssi_init(const char *optarg, void *userdata) {
+	isi_rssi_t *rssi;
+	GString *error;
+
+	rssi = g_new0(isi_rssi_t, 1);
+	rssi->width = ISI_RSSI_WIDTH;
+	if(!strncmp(optarg, "isi,rssi,", 9))
+		rssi->filter = g_strdup(optarg + 9);
+
+	error = register_tap_listener("isi.network", rssi, rssi->filter, TL_REQUIRES_NOTHING,
+		isi_rssi_reset, isi_rssi_packet, isi_rssi_draw);
+	if(error) {
+		fprintf(stderr, "tshark: Couldn't register isi,rssi tap: %s\n", error->str);
+		g_string_free(error, TRUE);
+		g_free(rssi->filter);
+		g_free(rssi);
+		exit(1);
+	}
+}
+
+void register_tap_listener_isi_rssi(void) {
+	register_stat_cmd_arg("isi,rssi", isi_rssi_init, NULL);
+}
@@ -0,0 +1,196 @@
+/* tap-isi-sats.c
+ * tshark -z isi,sats[,filter] - per PRN signal strength, in use ratio and
+ * sky grid from GPS_SAT_INFO
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+#include <epan/packet.h>
+#include <epan/tap.h>
+#include <epan/stat_cmd_args.h>
+
+#include "packet-isi.h"
+#include "isi-gps.h"
+
+/* signal strength histogram, the last bin takes everything above */
+#define ISI_SATS_SNR_WIDTH	5
+#define ISI_SATS_SNR_BINS	12
+
+/* sky grid: 15 degree elevation rings, 30 degree azimuth sectors */
+#define ISI_SATS_EL_WIDTH	15
+#define ISI_SATS_EL_BINS	(90 / ISI_SATS_EL_WIDTH)
+#define ISI_SATS_AZ_WIDTH	30
+#define ISI_SATS_AZ_BINS	(360 / ISI_SATS_AZ_WIDTH)
+
+typedef struct _isi_sats_prn_t {
+	guint32 seen;
+	guint32 used;
+	gfloat snr_min;
+	gfloat snr_max;
+	gdouble snr_sum;
+	guint32 snr_hist[ISI_SATS_SNR_BINS];
+} isi_sats_prn_t;
+
+typedef struct _isi_sats_sky_t {
+	guint32 count;
+	gdouble snr_sum;
+} isi_sats_sky_t;
+
+typedef struct _isi_sats_t {
+	char *filter;
+	guint32 frames;
+	isi_sats_prn_t prn[256];
+	isi_sats_sky_t sky[ISI_SATS_EL_BINS][ISI_SATS_AZ_BINS];
+} isi_sats_t;
+
+static guint isi_sats_bin(gfloat value, guint width, guint bins) {
+	guint bin;
+
+	if(value <= 0)
+		return 0;
+
+	bin = (guint) value / width;
+	return bin < bins ? bin : bins - 1;
+}
+
+static void isi_sats_reset(void *tapdata) {
+	isi_sats_t *sats = tapdata;
+
+	sats->frames = 0;
+	memset(sats->prn, 0, sizeof(sats->prn));
+	memset(sats->sky, 0, sizeof(sats->sky));
+}
+
+static int isi_sats_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt, const void *data) {
+	isi_sats_t *sats = tapdata;
+	const isi_gps_tap_info_t *info = data;
+	const isi_gps_sat_t *s;
+	isi_sats_prn_t *prn;
+	isi_sats_sky_t *sky;
+	guint i;
+
+	if(!info->has_satellites)
+		return 0;
+
+	for(i = 0; i < info->satellites; i++) {
+		s = &info->sat[i];
+		prn = &sats->prn[s->prn];
+
+		if(!prn->seen || s->strength < prn->snr_min)
+			prn->snr_min = s->strength;
+		if(!prn->seen || s->strength > prn->snr_max)
+			prn->snr_max = s->strength;
+		prn->snr_sum += s->strength;
+		prn->snr_hist[isi_sats_bin(s->strength, ISI_SATS_SNR_WIDTH, ISI_SATS_SNR_BINS)]++;
+		prn->seen++;
+		if(s->used)
+			prn->used++;
+
+		/* azimuth 360 is north again */
+		sky = &sats->sky[isi_sats_bin(s->elevation, ISI_SATS_EL_WIDTH, ISI_SATS_EL_BINS)]
+			[isi_sats_bin(s->azimuth < 360 ? s->azimuth : 0, ISI_SATS_AZ_WIDTH, ISI_SATS_AZ_BINS)];
+		sky->count++;
+		sky->snr_sum += s->strength;
+	}
+
+	sats->frames++;
+
+	return 1;
+}
+
+static void isi_sats_draw(void *tapdata) {
+	isi_sats_t *sats = tapdata;
+	const isi_sats_prn_t *prn;
+	const isi_sats_sky_t *sky;
+	guint i, j;
+
+	printf("\n");
+	printf("=========================================================================================\n");
+	printf("ISI GPS Satellites\n");
+	printf("Filter: %s\n", sats->filter ? sats->filter : "<none>");
+	printf("GPS_SAT_INFO frames: %u\n", sats->frames);
+
+	printf("\n%4s %8s %7s %8s %8s %8s\n", "PRN", "Seen", "In use", "SNR min", "SNR mean", "SNR max");
+	for(i = 0; i < 256; i++) {
+		prn = &sats->prn[i];
+		if(!prn->seen)
+			continue;
+
+		printf("%4u %8u %6.1f%% %8.2f %8.2f %8.2f\n", i, prn->seen, 100.0 * prn->used / prn->seen,
+			prn->snr_min, prn->snr_sum / prn->seen, prn->snr_max);
+	}
+
+	printf("\nSNR histogram (%d wide bins, last bin open)\n%4s", ISI_SATS_SNR_WIDTH, "PRN");
+	for(j = 0; j < ISI_SATS_SNR_BINS; j++)
+		printf(" %5u%s", j * ISI_SATS_SNR_WIDTH, j == ISI_SATS_SNR_BINS - 1 ? "+" : " ");
+	printf("\n");
+	for(i = 0; i < 256; i++) {
+		prn = &sats->prn[i];
+		if(!prn->seen)
+			continue;
+
+		printf("%4u", i);
+		for(j = 0; j < ISI_SATS_SNR_BINS; j++)
+			printf(" %6u", prn->snr_hist[j]);
+		printf("\n");
+	}
+
+	printf("\nSky grid, mean SNR (samples) by elevation and azimuth\n%-6s", "El\\Az");
+	for(j = 0; j < ISI_SATS_AZ_BINS; j++)
+		printf(" %11u", j * ISI_SATS_AZ_WIDTH);
+	printf("\n");
+	for(i = ISI_SATS_EL_BINS; i-- > 0; ) {
+		printf("%-6u", i * ISI_SATS_EL_WIDTH);
+		for(j = 0; j < ISI_SATS_AZ_BINS; j++) {
+			sky = &sats->sky[i][j];
+			if(sky->count)
+				printf(" %4.1f(%5u)", sky->snr_sum / sky->count, sky->count > 99999 ? 99999 : sky->count);
+			else
+				printf(" %11s", "-");
+		}
+		printf("\n");
+	}
+
+	printf("=========================================================================================\n");
+}
+
+static void isi_sats_init(const char *optarg, void *userdata) {
+	isi_sats_t *sats;
+	GString *error;
+
+	sats = g_new0(isi_sats_t, 1);
+	if(!strncmp(optarg, "isi,sats,", 9))
+		sats->filter = g_strdup(optarg + 9);
+
+	error = register_tap_listener("isi.gps", sats, sats->filter, TL_REQUIRES_NOTHING,
+		isi_sats_reset, isi_sats_packet, isi_sats_draw);
+	if(error) {
+		fprintf(stderr, "tshark: Couldn't register isi,sats tap: %s\n", error->str);
+		g_string_free(error, TRUE);
+		g_free(sats->filter);
+		g_free(sats);
+		exit(1);
+	}
+}
+
+void register_tap_listener_isi_sats(void) {
+	register_stat_cmd_arg("isi,sats", isi_sats_init, NULL);
+}
@@ -0,0 +1,345 @@
+/* tap-isi-sms.c
+ * tshark -z isi,sms[,filter] - SMS submit to delivery latency
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+#include <epan/packet.h>
+#include <epan/tap.h>
+#include <epan/stat_cmd_args.h>
+
+#include "packet-isi.h"
+#include "isi-sms.h"
+
+#define SMS_MESSAGE_SEND_REQ		0x02
+#define SMS_MESSAGE_SEND_RESP		0x03
+#define SMS_MESSAGE_SEND_STATUS_IND	0x22
+
+/* Stages of a submitted SMS. The status indication states map to
+ * stage status + 1. */
+enum {
+	ISI_SMS_STAGE_SUBMIT,
+	ISI_SMS_STAGE_REROUTED,
+	ISI_SMS_STAGE_REPEATED,
+	ISI_SMS_STAGE_WAITING,
+	ISI_SMS_STAGE_IDLE,
+	ISI_SMS_STAGE_RESULT,
+	ISI_SMS_STAGES
+};
+
+static const char *isi_sms_stage_names[ISI_SMS_STAGES] = {
+	"Submit", "Rerouted", "Repeated", "Waiting for Network", "Idle", "Result"
+};
+
+/* Latency histogram with logarithmic buckets: 16 linear sub-buckets per
+ * power of two of microseconds, so percentiles are within ~6% while the
+ * memory does not grow with the number of messages. */
+#define ISI_SMS_HIST_SUB	16
+#define ISI_SMS_HIST_BUCKETS	(64 * ISI_SMS_HIST_SUB)
+
+typedef struct _isi_sms_hist_t {
+	guint32 bucket[ISI_SMS_HIST_BUCKETS];
+	guint32 count;
+	guint64 sum;
+	guint64 max;
+} isi_sms_hist_t;
+
+/* SMS in flight, by message reference */
+typedef struct _isi_sms_slot_t {
+	gboolean active;
+	guint32 submit_frame;
+	nstime_t submit;
+	guint stage;
+	nstime_t stage_time;
+} isi_sms_slot_t;
+
+/* Requests still waiting for SMS_MESSAGE_SEND_RESP */
+#define ISI_SMS_PENDING 16
+
+typedef struct _isi_sms_pending_t {
+	guint32 frame;		/* 0 for a free entry */
+	nstime_t time;
+} isi_sms_pending_t;
+
+typedef struct _isi_sms_t {
+	char *filter;
+
+	isi_sms_slot_t slot[256];
+	isi_sms_pending_t pending[ISI_SMS_PENDING];
+	guint pending_next;
+
+	guint32 submits;
+	guint32 results;
+	guint32 unmatched;
+	guint32 orphans;	/* status without a pending submit */
+	guint32 idle;
+	guint32 abandoned;	/* reference reused before Idle */
+
+	guint32 transitions[ISI_SMS_STAGES][ISI_SMS_STAGES];
+	guint64 transition_us[ISI_SMS_STAGES][ISI_SMS_STAGES];
+
+	isi_sms_hist_t to_result;
+	isi_sms_hist_t to_idle;
+} isi_sms_t;
+
+static guint isi_sms_hist_bucket(guint64 us) {
+	guint msb = 0;
+
+	if(us < ISI_SMS_HIST_SUB)
+		return (guint) us;
+
+	while(us >> (msb + 1))
+		msb++;
+
+	return (msb - 3) * ISI_SMS_HIST_SUB + ((us >> (msb - 4)) & (ISI_SMS_HIST_SUB - 1));
+}
+
+/* middle of a bucket, in microseconds */
+static gdouble isi_sms_hist_value(guint bucket) {
+	guint msb;
+
+	if(bucket < ISI_SMS_HIST_SUB)
+		return bucket;
+
+	msb = bucket / ISI_SMS_HIST_SUB + 3;
+	return (gdouble) ((guint64) (ISI_SMS_HIST_SUB + bucket % ISI_SMS_HIST_SUB) << (msb - 4))
+		+ (gdouble) ((guint64) 1 << (msb - 4)) / 2;
+}
+
+static guint64 isi_sms_us(const nstime_t *t) {
+	if(t->secs < 0)
+		return 0;
+	return (guint64) t->secs * 1000000 + t->nsecs / 1000;
+}
+
+static void isi_sms_hist_add(isi_sms_hist_t *hist, const nstime_t *t) {
+	guint64 us = isi_sms_us(t);
+	guint bucket = isi_sms_hist_bucket(us);
+
+	hist->bucket[MIN(bucket, ISI_SMS_HIST_BUCKETS - 1)]++;
+	hist->count++;
+	hist->sum += us;
+	hist->max = MAX(hist->max, us);
+}
+
+/* percentile p (0..100) in seconds */
+static gdouble isi_sms_hist_percentile(const isi_sms_hist_t *hist, guint p) {
+	guint64 target = ((guint64) hist->count * p + 99) / 100;
+	guint64 seen = 0;
+	guint i;
+
+	for(i = 0; i < ISI_SMS_HIST_BUCKETS; i++) {
+		seen += hist->bucket[i];
+		if(seen >= target && seen)
+			return isi_sms_hist_value(i) / 1000000;
+	}
+
+	return 0;
+}
+
+static void isi_sms_reset(void *tapdata) {
+	isi_sms_t *sms = tapdata;
+	char *filter = sms->filter;
+
+	memset(sms, 0, sizeof(isi_sms_t));
+	sms->filter = filter;
+}
+
+static void isi_sms_transition(isi_sms_t *sms, isi_sms_slot_t *slot, guint stage, const nstime_t *now) {
+	nstime_t delta;
+
+	nstime_delta(&delta, now, &slot->stage_time);
+	sms->transitions[slot->stage][stage]++;
+	sms->transition_us[slot->stage][stage] += isi_sms_us(&delta);
+
+	slot->stage = stage;
+	slot->stage_time = *now;
+}
+
+/* The most recent request still waiting for its response. The request
+ * carries no message reference, so with several SMS in flight every new
+ * reference is tied to the newest submit. */
+static isi_sms_pending_t *isi_sms_last_pending(isi_sms_t *sms) {
+	isi_sms_pending_t *last = NULL;
+	guint i;
+
+	for(i = 0; i < ISI_SMS_PENDING; i++)
+		if(sms->pending[i].frame && (!last || sms->pending[i].frame > last->frame))
+			last = &sms->pending[i];
+
+	return last;
+}
+
+static void isi_sms_status(isi_sms_t *sms, packet_info *pinfo, const isi_sms_tap_info_t *info) {
+	isi_sms_slot_t *slot = &sms->slot[info->msg_ref];
+	isi_sms_pending_t *req = isi_sms_last_pending(sms);
+	const nstime_t *now = &pinfo->fd->abs_ts;
+	nstime_t delta;
+
+	if(info->status > ISI_SMS_MSG_IDLE)
+		return;
+
+	/* a newer submit took over the reference of an SMS which got its
+	 * result but never went Idle */
+	if(slot->active && slot->stage == ISI_SMS_STAGE_RESULT && req && req->frame > slot->submit_frame) {
+		sms->abandoned++;
+		slot->active = FALSE;
+	}
+
+	/* a reference first seen as Idle, or without a submit to tie it
+	 * to, has no latency to measure */
+	if(!slot->active && (!req || info->status == ISI_SMS_MSG_IDLE)) {
+		sms->orphans++;
+		return;
+	}
+
+	if(!slot->active) {
+		slot->active = TRUE;
+		slot->submit_frame = req->frame;
+		slot->submit = req->time;
+		slot->stage = ISI_SMS_STAGE_SUBMIT;
+		slot->stage_time = slot->submit;
+	}
+
+	isi_sms_transition(sms, slot, info->status + 1, now);
+
+	if(info->status == ISI_SMS_MSG_IDLE) {
+		nstime_delta(&delta, now, &slot->submit);
+		isi_sms_hist_add(&sms->to_idle, &delta);
+		sms->idle++;
+		slot->active = FALSE;
+	}
+}
+
+static void isi_sms_result(isi_sms_t *sms, packet_info *pinfo, const isi_sms_tap_info_t *info) {
+	guint i;
+
+	if(!info->request_in) {
+		sms->unmatched++;
+		return;
+	}
+
+	sms->results++;
+	isi_sms_hist_add(&sms->to_result, &info->response_time);
+
+	for(i = 0; i < ISI_SMS_PENDING; i++)
+		if(sms->pending[i].frame == info->request_in)
+			sms->pending[i].frame = 0;
+
+	for(i = 0; i < 256; i++)
+		if(sms->slot[i].active && sms->slot[i].submit_frame == info->request_in)
+			isi_sms_transition(sms, &sms->slot[i], ISI_SMS_STAGE_RESULT, &pinfo->fd->abs_ts);
+}
+
+static int isi_sms_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt, const void *data) {
+	isi_sms_t *sms = tapdata;
+	const isi_sms_tap_info_t *info = data;
+
+	switch(info->msg_id) {
+		case SMS_MESSAGE_SEND_REQ:
+			sms->submits++;
+			sms->pending[sms->pending_next].frame = pinfo->fd->num;
+			sms->pending[sms->pending_next].time = pinfo->fd->abs_ts;
+			sms->pending_next = (sms->pending_next + 1) % ISI_SMS_PENDING;
+			break;
+		case SMS_MESSAGE_SEND_RESP:
+			isi_sms_result(sms, pinfo, info);
+			break;
+		case SMS_MESSAGE_SEND_STATUS_IND:
+			isi_sms_status(sms, pinfo, info);
+			break;
+		default:
+			return 0;
+	}
+
+	return 1;
+}
+
+static void isi_sms_draw_hist(const char *name, const isi_sms_hist_t *hist) {
+	if(!hist->count) {
+		printf("%-18s %8u\n", name, 0);
+		return;
+	}
+
+	printf("%-18s %8u %10.6f %10.6f %10.6f %10.6f %10.6f\n", name, hist->count,
+		(gdouble) hist->sum / hist->count / 1000000,
+		isi_sms_hist_percentile(hist, 50), isi_sms_hist_percentile(hist, 95),
+		isi_sms_hist_percentile(hist, 99), (gdouble) hist->max / 1000000);
+}
+
+static void isi_sms_draw(void *tapdata) {
+	isi_sms_t *sms = tapdata;
+	guint in_flight = 0;
+	guint i, j;
+
+	for(i = 0; i < 256; i++)
+		if(sms->slot[i].active)
+			in_flight++;
+
+	printf("\n");
+	printf("=========================================================================================\n");
+	printf("ISI SMS Delivery\n");
+	printf("Filter: %s\n", sms->filter ? sms->filter : "<none>");
+	printf("\n");
+	printf("Submitted: %u  Results: %u (unmatched %u)  Idle: %u  In flight: %u  Abandoned: %u\n",
+		sms->submits, sms->results, sms->unmatched, sms->idle, in_flight, sms->abandoned);
+	printf("Status indications without a pending submit: %u\n", sms->orphans);
+	printf("Note: a new message reference is tied to the newest pending submit,\n"
+		"      overlapping submits may be attributed to the wrong request\n");
+
+	printf("\nLatency from submit (s)\n");
+	printf("%-18s %8s %10s %10s %10s %10s %10s\n", "", "Count", "Mean", "p50", "p95", "p99", "Max");
+	isi_sms_draw_hist("to result", &sms->to_result);
+	isi_sms_draw_hist("to idle", &sms->to_idle);
+
+	printf("\nStage transitions\n");
+	printf("%-20s    %-20s %8s %14s\n", "From", "To", "Count", "Mean time (s)");
+	for(i = 0; i < ISI_SMS_STAGES; i++)
+		for(j = 0; j < ISI_SMS_STAGES; j++)
+			if(sms->transitions[i][j])
+				printf("%-20s -> %-20s %8u %14.6f\n", isi_sms_stage_names[i], isi_sms_stage_names[j],
+					sms->transitions[i][j], (gdouble) sms->transition_us[i][j] / sms->transitions[i][j] / 1000000);
+
+	printf("=========================================================================================\n");
+}
+
+static void isi_sms_init(const char *optarg, void *userdata) {
+	isi_sms_t *sms;
+	GString *error;
+
+	sms = g_new0(isi_sms_t, 1);
+	if(!strncmp(optarg, "isi,sms,", 8))
+		sms->filter = g_strdup(optarg + 8);
+
+	error = register_tap_listener("isi.sms", sms, sms->filter, TL_REQUIRES_NOTHING,
+		isi_sms_reset, isi_sms_packet, isi_sms_draw);
+	if(error) {
+		fprintf(stderr, "tshark: Couldn't register isi,sms tap: %s\n", error->str);
+		g_string_free(error, TRUE);
+		g_free(sms->filter);
+		g_free(sms);
+		exit(1);
+	}
+}
+
+void register_tap_listener_isi_sms(void) {
+	register_stat_cmd_arg("isi,sms", isi_sms_init, NULL);
+}
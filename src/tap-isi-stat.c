@@ -0,0 +1,205 @@
+/* tap-isi-stat.c
+ * tshark -z isi,stat[,filter] - message counters per resource and message ID
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+#include <epan/packet.h>
+#include <epan/tap.h>
+#include <epan/stat_cmd_args.h>
+
+#include "packet-isi.h"
+
+/* Counters are kept per sending device */
+enum {
+	ISI_STAT_HOST,
+	ISI_STAT_MODEM,
+	ISI_STAT_OTHER,
+	ISI_STAT_DIRS
+};
+
+static const char *isi_stat_dir_names[ISI_STAT_DIRS] = {
+	"Host", "Modem", "Other"
+};
+
+typedef struct _isi_stat_counter_t {
+	guint32 msgs;
+	guint64 bytes;
+} isi_stat_counter_t;
+
+typedef struct _isi_stat_t {
+	char *filter;
+	gboolean seen;
+	nstime_t first;
+	nstime_t last;
+	gboolean visited;	/* a second pass, unanswered requests are known */
+	guint32 no_response;
+	isi_stat_counter_t res[256][ISI_STAT_DIRS];
+	/* (resource << 8 | msg_id) -> isi_stat_counter_t[ISI_STAT_DIRS] */
+	GHashTable *msgs;
+} isi_stat_t;
+
+static guint isi_stat_dir(const isi_tap_info_t *info) {
+	switch(info->sdev) {
+		case ISI_DEV_HOST:
+			return ISI_STAT_HOST;
+		case ISI_DEV_MODEM:
+			return ISI_STAT_MODEM;
+		default:
+			return ISI_STAT_OTHER;
+	}
+}
+
+static void isi_stat_reset(void *tapdata) {
+	isi_stat_t *st = tapdata;
+
+	st->seen = FALSE;
+	st->visited = FALSE;
+	st->no_response = 0;
+	memset(st->res, 0, sizeof(st->res));
+	g_hash_table_remove_all(st->msgs);
+}
+
+static int isi_stat_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt, const void *data) {
+	isi_stat_t *st = tapdata;
+	const isi_tap_info_t *info = data;
+	isi_stat_counter_t *cnt;
+	guint dir = isi_stat_dir(info);
+	gpointer key;
+
+	if(!st->seen) {
+		st->first = pinfo->fd->abs_ts;
+		st->seen = TRUE;
+	}
+	st->last = pinfo->fd->abs_ts;
+
+	if(pinfo->fd->flags.visited)
+		st->visited = TRUE;
+	if(info->no_response)
+		st->no_response++;
+
+	st->res[info->resource][dir].msgs++;
+	st->res[info->resource][dir].bytes += info->len;
+
+	if(!info->has_msg_id)
+		return 1;
+
+	key = GUINT_TO_POINTER(info->resource << 8 | info->msg_id);
+	cnt = g_hash_table_lookup(st->msgs, key);
+	if(!cnt) {
+		cnt = g_new0(isi_stat_counter_t, ISI_STAT_DIRS);
+		g_hash_table_insert(st->msgs, key, cnt);
+	}
+
+	cnt[dir].msgs++;
+	cnt[dir].bytes += info->len;
+
+	return 1;
+}
+
+/* name is indented below its resource for message IDs */
+static void isi_stat_print_line(gboolean indent, const char *name, guint dir, const isi_stat_counter_t *cnt, gdouble duration) {
+	int width = indent ? 38 : 40;
+
+	printf("%s%-*.*s %-6s %10u %12" G_GINT64_MODIFIER "u", indent ? "  " : "", width, width,
+		name, isi_stat_dir_names[dir], cnt->msgs, cnt->bytes);
+
+	if(duration > 0)
+		printf(" %10.3f\n", cnt->msgs / duration);
+	else
+		printf(" %10s\n", "-");
+}
+
+static void isi_stat_draw(void *tapdata) {
+	isi_stat_t *st = tapdata;
+	isi_stat_counter_t *cnt;
+	nstime_t delta;
+	gdouble duration = 0;
+	guint resource, msg_id, dir;
+	char *name;
+
+	if(st->seen) {
+		nstime_delta(&delta, &st->last, &st->first);
+		duration = nstime_to_sec(&delta);
+	}
+
+	printf("\n");
+	printf("=========================================================================================\n");
+	printf("ISI Statistics\n");
+	printf("Filter: %s\n", st->filter ? st->filter : "<none>");
+	printf("Duration: %.3f s\n", duration);
+	if(st->visited)
+		printf("Requests without response: %u\n", st->no_response);
+	else
+		printf("Requests without response: - (needs a second pass, tshark -2)\n");
+	printf("\n");
+	printf("%-40s %-6s %10s %12s %10s\n", "Resource / Message ID", "Sender", "Messages", "Bytes", "Msgs/s");
+
+	for(resource = 0; resource < 256; resource++) {
+		for(dir = 0; dir < ISI_STAT_DIRS; dir++) {
+			if(!st->res[resource][dir].msgs)
+				continue;
+
+			name = g_strdup_printf("0x%02x %s", resource, isi_resource_name(resource));
+			isi_stat_print_line(FALSE, name, dir, &st->res[resource][dir], duration);
+			g_free(name);
+		}
+
+		for(msg_id = 0; msg_id < 256; msg_id++) {
+			cnt = g_hash_table_lookup(st->msgs, GUINT_TO_POINTER(resource << 8 | msg_id));
+			if(!cnt)
+				continue;
+
+			name = g_strdup_printf("0x%02x %s", msg_id, isi_message_name(resource, msg_id));
+			for(dir = 0; dir < ISI_STAT_DIRS; dir++)
+				if(cnt[dir].msgs)
+					isi_stat_print_line(TRUE, name, dir, &cnt[dir], duration);
+			g_free(name);
+		}
+	}
+
+	printf("=========================================================================================\n");
+}
+
+static void isi_stat_init(const char *optarg, void *userdata) {
+	isi_stat_t *st;
+	GString *error;
+
+	st = g_new0(isi_stat_t, 1);
+	if(!strncmp(optarg, "isi,stat,", 9))
+		st->filter = g_strdup(optarg + 9);
+	st->msgs = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
+
+	error = register_tap_listener("isi", st, st->filter, TL_REQUIRES_NOTHING,
+		isi_stat_reset, isi_stat_packet, isi_stat_draw);
+	if(error) {
+		fprintf(stderr, "tshark: Couldn't register isi,stat tap: %s\n", error->str);
+		g_string_free(error, TRUE);
+		g_hash_table_destroy(st->msgs);
+		g_free(st->filter);
+		g_free(st);
+		exit(1);
+	}
+}
+
+void register_tap_listener_isi_stat(void) {
+	register_stat_cmd_arg("isi,stat", isi_stat_init, NULL);
+}
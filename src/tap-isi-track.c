@@ -0,0 +1,382 @@
+/* tap-isi-track.c
+ * tshark -z isi,track,<gpx|nmea|csv>,<file|-|tcp:port>[,filter] - writes
+ * the GPS positions while dissecting, tcp:port only serves nmea
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <glib.h>
+#include <epan/packet.h>
+#include <epan/tap.h>
+#include <epan/stat_cmd_args.h>
+
+#if defined(HAVE_SYS_SOCKET_H) && defined(HAVE_NETINET_IN_H) && defined(HAVE_UNISTD_H)
+# define ISI_TRACK_TCP
+# include <sys/socket.h>
+# include <netinet/in.h>
+# include <unistd.h>
+# include <fcntl.h>
+# ifndef MSG_NOSIGNAL
+#  define MSG_NOSIGNAL 0
+# endif
+#endif
+
+#include "packet-isi.h"
+#include "isi-gps.h"
+
+#define KMH_TO_KNOTS (1 / 1.852)
+
+enum {
+	ISI_TRACK_GPX,
+	ISI_TRACK_NMEA,
+	ISI_TRACK_CSV
+};
+
+static const char *isi_track_formats[] = {
+	"gpx", "nmea", "csv"
+};
+
+typedef struct _isi_track_t {
+	char *filter;
+	char *dest;
+	int format;
+	FILE *out;
+	gboolean started;
+	guint32 points;
+#ifdef ISI_TRACK_TCP
+	int listen_fd;
+	GArray *clients;
+#endif
+} isi_track_t;
+
+#ifdef ISI_TRACK_TCP
+/* local NMEA feed for gpsd compatible clients, they may come and go. NMEA
+ * sentences stand alone, a gpx or csv client joining late would miss the
+ * header, so tcp is limited to nmea. A client that can't keep up is
+ * dropped instead of stalling the dissection. */
+static gboolean isi_track_listen(isi_track_t *track, guint16 port) {
+	struct sockaddr_in addr;
+	int one = 1;
+
+	track->listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+	if(track->listen_fd < 0)
+		return FALSE;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr.sin_port = htons(port);
+
+	setsockopt(track->listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+	if(bind(track->listen_fd, (struct sockaddr *) &addr, sizeof(addr)) < 0 ||
+	   listen(track->listen_fd, 4) < 0 ||
+	   fcntl(track->listen_fd, F_SETFL, O_NONBLOCK) < 0) {
+		close(track->listen_fd);
+		track->listen_fd = -1;
+		return FALSE;
+	}
+
+	track->clients = g_array_new(FALSE, FALSE, sizeof(int));
+	return TRUE;
+}
+
+static void isi_track_send(isi_track_t *track, const char *line) {
+	size_t len = strlen(line);
+	int fd;
+	guint i;
+
+	while((fd = accept(track->listen_fd, NULL, NULL)) >= 0) {
+		if(fcntl(fd, F_SETFL, O_NONBLOCK) < 0) {
+			close(fd);
+			continue;
+		}
+		g_array_append_val(track->clients, fd);
+	}
+
+	for(i = 0; i < track->clients->len; ) {
+		fd = g_array_index(track->clients, int, i);
+		/* a short write or EAGAIN would leave a partial sentence */
+		if(send(fd, line, len, MSG_NOSIGNAL) != (ssize_t) len) {
+			close(fd);
+			g_array_remove_index_fast(track->clients, i);
+			continue;
+		}
+		i++;
+	}
+}
+#endif
+
+static void isi_track_write(isi_track_t *track, const char *line) {
+	if(track->out) {
+		fputs(line, track->out);
+		fflush(track->out);
+	}
+#ifdef ISI_TRACK_TCP
+	if(track->listen_fd >= 0)
+		isi_track_send(track, line);
+#endif
+}
+
+/* UTC of the fix, the capture time is used without a GPS_TIME_DATE */
+static void isi_track_time(const isi_gps_tap_info_t *info, packet_info *pinfo, struct tm *tm, double *second) {
+	time_t t;
+
+	if(info->has_time) {
+		memset(tm, 0, sizeof(*tm));
+		tm->tm_year = info->year - 1900;
+		tm->tm_mon = info->month - 1;
+		tm->tm_mday = info->day;
+		tm->tm_hour = info->hour;
+		tm->tm_min = info->minute;
+		*second = info->second;
+		return;
+	}
+
+	t = pinfo->fd->abs_ts.secs;
+	*tm = *gmtime(&t);
+	*second = tm->tm_sec + pinfo->fd->abs_ts.nsecs / 1000000000.0;
+}
+
+/* ddmm.mmmm / dddmm.mmmm with hemisphere */
+static void isi_track_nmea_coord(GString *s, double deg, int digits, char pos, char neg) {
+	char hemi = deg < 0 ? neg : pos;
+	guint32 min;
+	int d;
+
+	if(deg < 0)
+		deg = -deg;
+	d = (int) deg;
+
+	/* 1/10000 minutes, rounded before printing so 59.99999 carries over */
+	min = (guint32) ((deg - d) * 600000 + 0.5);
+	if(min >= 600000) {
+		d++;
+		min -= 600000;
+	}
+
+	g_string_append_printf(s, ",%0*d%02u.%04u,%c", digits, d, min / 10000, min % 10000, hemi);
+}
+
+static void isi_track_nmea_end(GString *s) {
+	guint8 sum = 0;
+	gsize i;
+
+	for(i = 1; i < s->len; i++)
+		sum ^= s->str[i];
+	g_string_append_printf(s, "*%02X\r\n", sum);
+}
+
+static void isi_track_nmea(isi_track_t *track, const isi_gps_tap_info_t *info, const struct tm *tm, double second) {
+	GString *s = g_string_new("");
+	GString *line = g_string_new("$GPGGA");
+
+	g_string_append_printf(line, ",%02d%02d%05.2f", tm->tm_hour, tm->tm_min, second);
+	isi_track_nmea_coord(line, info->lat, 2, 'N', 'S');
+	isi_track_nmea_coord(line, info->lon, 3, 'E', 'W');
+	if(info->has_satellites)
+		g_string_append_printf(line, ",1,%02u,,%d,M,,M,,", info->satellites_used, info->altitude);
+	else
+		g_string_append_printf(line, ",1,,,%d,M,,M,,", info->altitude);
+	isi_track_nmea_end(line);
+	g_string_append(s, line->str);
+
+	g_string_assign(line, "$GPRMC");
+	g_string_append_printf(line, ",%02d%02d%05.2f,A", tm->tm_hour, tm->tm_min, second);
+	isi_track_nmea_coord(line, info->lat, 2, 'N', 'S');
+	isi_track_nmea_coord(line, info->lon, 3, 'E', 'W');
+	if(info->has_movement)
+		g_string_append_printf(line, ",%.1f,%.1f", info->speed * KMH_TO_KNOTS, info->course);
+	else
+		g_string_append(line, ",,");
+	g_string_append_printf(line, ",%02d%02d%02d,,,A", tm->tm_mday, tm->tm_mon + 1, tm->tm_year % 100);
+	isi_track_nmea_end(line);
+	g_string_append(s, line->str);
+
+	isi_track_write(track, s->str);
+	g_string_free(line, TRUE);
+	g_string_free(s, TRUE);
+}
+
+static const char isi_track_gpx_head[] =
+	"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+	"<gpx version=\"1.1\" creator=\"isi-wireshark-plugin\" xmlns=\"http://www.topografix.com/GPX/1/1\">\n"
+	"<trk><trkseg>\n";
+
+static void isi_track_gpx(isi_track_t *track, const isi_gps_tap_info_t *info, const struct tm *tm, double second) {
+	GString *s = g_string_new("");
+
+	if(!track->started)
+		g_string_append(s, isi_track_gpx_head);
+
+	g_string_append_printf(s, "<trkpt lat=\"%.7f\" lon=\"%.7f\"><ele>%d</ele>"
+		"<time>%04d-%02d-%02dT%02d:%02d:%06.3fZ</time>", info->lat, info->lon, info->altitude,
+		tm->tm_year + 1900, tm->tm_mon + 1, tm->tm_mday, tm->tm_hour, tm->tm_min, second);
+	if(info->has_satellites)
+		g_string_append_printf(s, "<sat>%u</sat>", info->satellites_used);
+	g_string_append(s, "</trkpt>\n");
+
+	isi_track_write(track, s->str);
+	g_string_free(s, TRUE);
+}
+
+static void isi_track_csv(isi_track_t *track, const isi_gps_tap_info_t *info, packet_info *pinfo, const struct tm *tm, double second) {
+	GString *s = g_string_new("");
+
+	if(!track->started)
+		g_string_append(s, "frame,rel_time,utc,lat,lon,alt,eph,epv,speed,course,climb,satellites,used\n");
+
+	g_string_append_printf(s, "%u,%.6f,%04d-%02d-%02dT%02d:%02d:%06.3fZ,%.7f,%.7f,%d,%.2f,%.2f,",
+		pinfo->fd->num, nstime_to_sec(&pinfo->fd->rel_ts),
+		tm->tm_year + 1900, tm->tm_mon + 1, tm->tm_mday, tm->tm_hour, tm->tm_min, second,
+		info->lat, info->lon, info->altitude, info->eph, info->epv);
+	if(info->has_movement)
+		g_string_append_printf(s, "%.2f,%.2f,%.2f,", info->speed, info->course, info->climb);
+	else
+		g_string_append(s, ",,,");
+	if(info->has_satellites)
+		g_string_append_printf(s, "%u,%u\n", info->satellites, info->satellites_used);
+	else
+		g_string_append(s, ",\n");
+
+	isi_track_write(track, s->str);
+	g_string_free(s, TRUE);
+}
+
+static int isi_track_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt, const void *data) {
+	isi_track_t *track = tapdata;
+	const isi_gps_tap_info_t *info = data;
+	struct tm tm;
+	double second;
+
+	if(!info->has_position)
+		return 0;
+
+	isi_track_time(info, pinfo, &tm, &second);
+
+	switch(track->format) {
+		case ISI_TRACK_GPX:
+			isi_track_gpx(track, info, &tm, second);
+			break;
+		case ISI_TRACK_NMEA:
+			isi_track_nmea(track, info, &tm, second);
+			break;
+		default:
+			isi_track_csv(track, info, pinfo, &tm, second);
+			break;
+	}
+
+	track->started = TRUE;
+	track->points++;
+
+	return 1;
+}
+
+static void isi_track_draw(void *tapdata) {
+	isi_track_t *track = tapdata;
+
+	/* an empty track is still a valid document */
+	if(track->format == ISI_TRACK_GPX) {
+		if(!track->started)
+			isi_track_write(track, isi_track_gpx_head);
+		isi_track_write(track, "</trkseg></trk>\n</gpx>\n");
+		track->started = TRUE;
+	}
+
+	/* do not mix the summary into an export on stdout */
+	if(track->out == stdout)
+		return;
+
+	printf("\n");
+	printf("=========================================================================================\n");
+	printf("ISI GPS Track Export\n");
+	printf("Filter: %s\n", track->filter ? track->filter : "<none>");
+	printf("%u %s points written to %s\n", track->points, isi_track_formats[track->format], track->dest);
+	printf("=========================================================================================\n");
+}
+
+static void isi_track_init(const char *optarg, void *userdata) {
+	isi_track_t *track;
+	GString *error;
+	gchar **args;
+	guint i;
+
+	/* isi,track,<format>,<dest>[,filter] */
+	args = g_strsplit(optarg, ",", 5);
+	if(g_strv_length(args) < 4) {
+		fprintf(stderr, "tshark: invalid \"-z isi,track,<gpx|nmea|csv>,<file|-|tcp:port>[,filter]\" argument\n");
+		exit(1);
+	}
+
+	track = g_new0(isi_track_t, 1);
+	track->format = -1;
+	for(i = 0; i < G_N_ELEMENTS(isi_track_formats); i++)
+		if(!strcmp(args[2], isi_track_formats[i]))
+			track->format = i;
+	if(track->format < 0) {
+		fprintf(stderr, "tshark: isi,track: unknown format \"%s\"\n", args[2]);
+		exit(1);
+	}
+
+	track->dest = g_strdup(args[3]);
+	if(args[4])
+		track->filter = g_strdup(args[4]);
+	g_strfreev(args);
+
+#ifdef ISI_TRACK_TCP
+	track->listen_fd = -1;
+#endif
+
+	if(!strcmp(track->dest, "-")) {
+		track->out = stdout;
+	} else if(!strncmp(track->dest, "tcp:", 4)) {
+#ifdef ISI_TRACK_TCP
+		if(track->format != ISI_TRACK_NMEA) {
+			fprintf(stderr, "tshark: isi,track: tcp output is only supported for nmea\n");
+			exit(1);
+		}
+		if(!isi_track_listen(track, (guint16) atoi(track->dest + 4))) {
+			fprintf(stderr, "tshark: isi,track: can't listen on %s\n", track->dest);
+			exit(1);
+		}
+#else
+		fprintf(stderr, "tshark: isi,track: tcp output is not supported on this platform\n");
+		exit(1);
+#endif
+	} else {
+		track->out = fopen(track->dest, "w");
+		if(!track->out) {
+			fprintf(stderr, "tshark: isi,track: can't open %s\n", track->dest);
+			exit(1);
+		}
+	}
+
+	error = register_tap_listener("isi.gps", track, track->filter, TL_REQUIRES_NOTHING,
+		NULL, isi_track_packet, isi_track_draw);
+	if(error) {
+		fprintf(stderr, "tshark: Couldn't register isi,track tap: %s\n", error->str);
+		g_string_free(error, TRUE);
+		exit(1);
+	}
+}
+
+void register_tap_listener_isi_track(void) {
+	register_stat_cmd_arg("isi,track", isi_track_init, NULL);
+}
@@ -0,0 +1,66 @@
+#!/usr/bin/env python3
+# check-value-strings.py
+# Build time sanity check for the value_string tables of the ISI plugin
+#
+# Every table has to be terminated by a {0x00, NULL} entry and must not
+# contain a key twice. Tables used through VALUE_STRING_EXT_INIT() are
+# looked up by direct indexing or binary search, so they also have to be
+# sorted by key.
+#
+# usage: check-value-strings.py file.c [file.c ...]
+
+import re
+import sys
+
+TABLE_RE = re.compile(r'value_string\s+(\w+)\s*\[\s*\]\s*=\s*\{(.*?)\}\s*;', re.S)
+ENTRY_RE = re.compile(r'\{\s*([^,{}]+?)\s*,\s*(NULL|"(?:[^"\\]|\\.)*")\s*\}')
+EXT_RE = re.compile(r'VALUE_STRING_EXT_INIT\s*\(\s*(\w+)\s*\)')
+
+def strip_comments(src):
+	src = re.sub(r'/\*.*?\*/', lambda m: '\n' * m.group(0).count('\n'), src, flags=re.S)
+	return re.sub(r'//[^\n]*', '', src)
+
+def check_file(path):
+	errors = []
+	src = strip_comments(open(path).read())
+	ext = set(EXT_RE.findall(src))
+
+	for table in TABLE_RE.finditer(src):
+		name = table.group(1)
+		line = src.count('\n', 0, table.start()) + 1
+		entries = [(int(k, 0), v) for k, v in ENTRY_RE.findall(table.group(2))]
+
+		def error(msg):
+			errors.append('%s:%d: %s: %s' % (path, line, name, msg))
+
+		if not entries or entries[-1][1] != 'NULL':
+			error('missing {0x00, NULL} terminator')
+			continue
+
+		keys = [k for k, v in entries[:-1]]
+		if 'NULL' in [v for k, v in entries[:-1]]:
+			error('NULL string before the end of the table')
+
+		seen = set()
+		for k in keys:
+			if k in seen:
+				error('duplicate key 0x%02x' % k)
+			seen.add(k)
+
+		if name in ext and keys != sorted(keys):
+			error('extended table is not sorted by key')
+
+	for name in ext:
+		if not re.search(r'value_string\s+%s\s*\[' % name, src):
+			errors.append('%s: %s: extended table not found' % (path, name))
+
+	return errors
+
+errors = []
+for path in sys.argv[1:]:
+	errors += check_file(path)
+
+for e in errors:
+	print(e, file=sys.stderr)
+
+sys.exit(1 if errors else 0)